@@ -0,0 +1,85 @@
+#include "bench_encoder.h"
+
+#define BENCH_KEYFRAME_INTERVAL 60
+#define BENCH_FRAME_BYTES 8192
+
+void bench_make_avc_access_unit(std::vector<uint8_t> &out, size_t size, bool keyframe, uint32_t seed)
+{
+    static const uint8_t start_code[4] = {0, 0, 0, 1};
+    uint32_t state = seed * 2654435761u + 1;
+
+    auto push_nal = [&](uint8_t header, size_t payload) {
+        out.insert(out.end(), start_code, start_code + 4);
+        out.push_back(header);
+        for (size_t i = 0; i < payload; i++) {
+            state = state * 1664525u + 1013904223u;
+            /* never zero, so no accidental start codes */
+            out.push_back((uint8_t)(state >> 24) | 1);
+        }
+    };
+
+    out.clear();
+    out.reserve(size + 64);
+
+    if (keyframe) {
+        push_nal(0x67, 16); /* sps */
+        push_nal(0x68, 4);  /* pps */
+    }
+
+    /* split the picture into four slices */
+    size_t slice = size / 4;
+    for (int i = 0; i < 4; i++)
+        push_nal(keyframe ? 0x65 : 0x41, slice);
+}
+
+bench_encoder::bench_encoder(obs_encoder_type type, video_format format)
+    : lite_obs_encoder(0), type(type), format(format)
+{
+}
+
+bool bench_encoder::i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, bool *received_packet)
+{
+    if (on_frame)
+        on_frame(frame);
+
+    bool keyframe = true;
+    if (type == obs_encoder_type::OBS_ENCODER_VIDEO) {
+        uint32_t height = lite_obs_encoder_get_height();
+        uint64_t sum = 0;
+
+        /* read every plane once, like an encoder would */
+        for (size_t plane = 0; plane < MAX_AV_PLANES && frame->data[plane]; plane++) {
+            uint32_t rows = (plane == 0 || format == video_format::VIDEO_FORMAT_I444) ? height : height / 2;
+            const uint8_t *p = frame->data[plane];
+            size_t bytes = (size_t)frame->linesize[plane] * rows;
+            for (size_t i = 0; i < bytes; i += 8)
+                sum += p[i];
+        }
+        checksum += sum;
+
+        keyframe = (frame_count % BENCH_KEYFRAME_INTERVAL) == 0;
+    }
+
+    packet->data = std::make_shared<std::vector<uint8_t>>();
+    bench_make_avc_access_unit(*packet->data, BENCH_FRAME_BYTES, keyframe, (uint32_t)frame_count);
+    packet->pts = frame->pts;
+    packet->dts = frame->pts;
+    packet->type = type;
+    packet->keyframe = keyframe;
+
+    frame_count++;
+    *received_packet = true;
+    return true;
+}
+
+void bench_encoder::i_get_audio_info(audio_convert_info *info)
+{
+    info->format = audio_format::AUDIO_FORMAT_FLOAT_PLANAR;
+    info->samples_per_sec = 48000;
+    info->speakers = speaker_layout::SPEAKERS_STEREO;
+}
+
+void bench_encoder::i_get_video_info(video_scale_info *info)
+{
+    info->format = format;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "lite_encoder.h"
+#include "media-io/video_scaler.h"
+#include "media-io/audio_output.h"
+
+void bench_make_avc_access_unit(std::vector<uint8_t> &out, size_t size, bool keyframe, uint32_t seed);
+
+/* stand-in encoder: reads the whole frame like a real encoder would and
+ * emits a synthetic annex-b access unit, so the pipeline around it can be
+ * measured without depending on a hardware/ffmpeg encoder */
+class bench_encoder : public lite_obs_encoder
+{
+public:
+    bench_encoder(obs_encoder_type type, video_format format = video_format::VIDEO_FORMAT_I420);
+
+    virtual const char *i_encoder_codec() { return "bench"; }
+    virtual obs_encoder_type i_encoder_type() { return type; }
+    virtual bool i_create() { return true; }
+    virtual void i_destroy() {}
+    virtual bool encoder_valid() { return true; }
+    virtual bool i_encode(encoder_frame *frame, std::shared_ptr<encoder_packet> packet, bool *received_packet);
+    virtual size_t i_get_frame_size() { return 1024; }
+    virtual void i_get_audio_info(struct audio_convert_info *info);
+    virtual void i_get_video_info(struct video_scale_info *info);
+
+    std::function<void(encoder_frame *frame)> on_frame;
+    uint64_t checksum{};
+
+private:
+    obs_encoder_type type;
+    video_format format;
+    uint64_t frame_count{};
+};
@@ -0,0 +1,250 @@
+#include "lite_obs_bench.h"
+#include "bench_encoder.h"
+#include "util/circlebuf.h"
+#include "util/log.h"
+#include "media-io/video_frame.h"
+#include "media-io/video_scaler.h"
+#include "media-io/audio_resampler.h"
+#include "media-io/audio_math.h"
+#include "lite_obs_core_video.h"
+#include "lite_obs_avc.h"
+#include "lite_output.h"
+#include "output/null_output.h"
+
+#include <string.h>
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 360
+#define BENCH_I420_SIZE (BENCH_WIDTH * BENCH_HEIGHT * 3 / 2)
+
+static void load_i420(video_frame_buffer &buffer, const std::vector<uint8_t> &yuv)
+{
+    buffer.video_frame_buffer_init(video_format::VIDEO_FORMAT_I420, BENCH_WIDTH, BENCH_HEIGHT);
+    auto &frame = buffer.frame();
+
+    const uint8_t *src = yuv.data();
+    memcpy(frame.data[0], src, BENCH_WIDTH * BENCH_HEIGHT);
+    src += BENCH_WIDTH * BENCH_HEIGHT;
+    memcpy(frame.data[1], src, BENCH_WIDTH * BENCH_HEIGHT / 4);
+    src += BENCH_WIDTH * BENCH_HEIGHT / 4;
+    memcpy(frame.data[2], src, BENCH_WIDTH * BENCH_HEIGHT / 4);
+}
+
+static void bench_circlebuf(bench_suite &suite)
+{
+    circlebuf cb;
+    circlebuf_init(&cb);
+
+    uint8_t chunk[4096];
+    memset(chunk, 0x5a, sizeof(chunk));
+
+    /* keep ~64k queued so pushes and pops wrap around */
+    for (int i = 0; i < 16; i++)
+        circlebuf_push_back(&cb, chunk, sizeof(chunk));
+
+    suite.run("circlebuf_push_pop_4k", 200000, sizeof(chunk) * 2, [&] {
+        circlebuf_push_back(&cb, chunk, sizeof(chunk));
+        circlebuf_pop_front(&cb, chunk, sizeof(chunk));
+    });
+
+    circlebuf_free(&cb);
+}
+
+static void bench_scaler_case(bench_suite &suite, const char *name, const video_frame &src, video_format src_format, video_format dst_format)
+{
+    if (!suite.enabled(name))
+        return;
+
+    video_scale_info from{};
+    from.format = src_format;
+    from.width = BENCH_WIDTH;
+    from.height = BENCH_HEIGHT;
+
+    video_scale_info to = from;
+    to.format = dst_format;
+
+    video_scaler scaler;
+    if (scaler.create(&to, &from, video_scale_type::VIDEO_SCALE_FAST_BILINEAR) != VIDEO_SCALER_SUCCESS) {
+        blog(LOG_WARNING, "bench: failed to create scaler for %s", name);
+        return;
+    }
+
+    video_frame_buffer dst;
+    dst.video_frame_buffer_init(dst_format, BENCH_WIDTH, BENCH_HEIGHT);
+    auto &out = dst.frame();
+
+    suite.run(name, 2000, BENCH_I420_SIZE, [&] {
+        scaler.video_scaler_scale((uint8_t **)out.data, out.linesize, (const uint8_t *const *)src.data, src.linesize);
+    });
+}
+
+static void bench_scaler(bench_suite &suite, const std::vector<uint8_t> &yuv)
+{
+    video_frame_buffer i420;
+    load_i420(i420, yuv);
+
+    bench_scaler_case(suite, "video_scaler_i420_to_nv12", i420.frame(), video_format::VIDEO_FORMAT_I420, video_format::VIDEO_FORMAT_NV12);
+    bench_scaler_case(suite, "video_scaler_i420_to_i444", i420.frame(), video_format::VIDEO_FORMAT_I420, video_format::VIDEO_FORMAT_I444);
+
+    /* nv12 source for the reverse direction */
+    video_scale_info from{video_format::VIDEO_FORMAT_I420, BENCH_WIDTH, BENCH_HEIGHT};
+    video_scale_info to{video_format::VIDEO_FORMAT_NV12, BENCH_WIDTH, BENCH_HEIGHT};
+    video_scaler to_nv12;
+    if (to_nv12.create(&to, &from, video_scale_type::VIDEO_SCALE_FAST_BILINEAR) != VIDEO_SCALER_SUCCESS)
+        return;
+
+    video_frame_buffer nv12;
+    nv12.video_frame_buffer_init(video_format::VIDEO_FORMAT_NV12, BENCH_WIDTH, BENCH_HEIGHT);
+    auto &src = i420.frame();
+    auto &dst = nv12.frame();
+    to_nv12.video_scaler_scale((uint8_t **)dst.data, dst.linesize, (const uint8_t *const *)src.data, src.linesize);
+
+    bench_scaler_case(suite, "video_scaler_nv12_to_i420", nv12.frame(), video_format::VIDEO_FORMAT_NV12, video_format::VIDEO_FORMAT_I420);
+}
+
+static void bench_converted_plane(bench_suite &suite, const std::vector<uint8_t> &yuv)
+{
+    std::vector<uint8_t> out((BENCH_WIDTH + 64) * BENCH_HEIGHT);
+
+    suite.run("set_gpu_converted_plane_packed", 5000, BENCH_WIDTH * BENCH_HEIGHT, [&] {
+        set_gpu_converted_plane(BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH, BENCH_WIDTH, yuv.data(), out.data());
+    });
+
+    suite.run("set_gpu_converted_plane_padded", 5000, BENCH_WIDTH * BENCH_HEIGHT, [&] {
+        set_gpu_converted_plane(BENCH_WIDTH, BENCH_HEIGHT, BENCH_WIDTH, BENCH_WIDTH + 64, yuv.data(), out.data());
+    });
+}
+
+static void bench_audio(bench_suite &suite)
+{
+    std::vector<float> samples(MAX_AUDIO_CHANNELS * AUDIO_OUTPUT_FRAMES);
+    for (size_t i = 0; i < samples.size(); i++)
+        samples[i] = (float)((int)(i % 401) - 200) / 100.0f;
+
+    suite.run("audio_clamp_8ch_1024", 50000, samples.size() * sizeof(float), [&] {
+        audio_clamp_samples(samples.data(), samples.size());
+    });
+
+    std::vector<float> mix(samples.size());
+    suite.run("audio_mix_8ch_1024", 50000, samples.size() * sizeof(float), [&] {
+        audio_mix_samples(mix.data(), samples.data(), 0.5f, samples.size());
+    });
+
+    suite.run("audio_mix_clamp_8ch_1024", 50000, samples.size() * sizeof(float), [&] {
+        audio_mix_clamp_samples(mix.data(), samples.data(), 0.5f, samples.size());
+    });
+
+    if (!suite.enabled("audio_resample_48k_f32p_to_44k1_s16"))
+        return;
+
+    resample_info src{48000, audio_format::AUDIO_FORMAT_FLOAT_PLANAR, speaker_layout::SPEAKERS_STEREO};
+    resample_info dst{44100, audio_format::AUDIO_FORMAT_16BIT, speaker_layout::SPEAKERS_STEREO};
+    audio_resampler resampler;
+    if (!resampler.create(&dst, &src)) {
+        blog(LOG_WARNING, "bench: failed to create resampler");
+        return;
+    }
+
+    const uint8_t *input[2] = {(const uint8_t *)samples.data(), (const uint8_t *)(samples.data() + AUDIO_OUTPUT_FRAMES)};
+    uint8_t *output[MAX_AV_PLANES] = {};
+    uint32_t out_frames = 0;
+    uint64_t ts_offset = 0;
+
+    suite.run("audio_resample_48k_f32p_to_44k1_s16", 20000, AUDIO_OUTPUT_FRAMES * 2 * sizeof(float), [&] {
+        resampler.do_resample(output, &out_frames, &ts_offset, input, AUDIO_OUTPUT_FRAMES);
+    });
+}
+
+static void bench_avc(bench_suite &suite)
+{
+    auto src = std::make_shared<encoder_packet>();
+    src->data = std::make_shared<std::vector<uint8_t>>();
+    src->type = obs_encoder_type::OBS_ENCODER_VIDEO;
+    src->timebase_num = 1;
+    src->timebase_den = 30;
+    bench_make_avc_access_unit(*src->data, 64 * 1024, true, 1);
+
+    const uint8_t *begin = src->data->data();
+    const uint8_t *end = begin + src->data->size();
+
+    suite.run("obs_avc_find_startcode_64k", 20000, src->data->size(), [&] {
+        const uint8_t *p = begin;
+        while ((p = obs_avc_find_startcode(p, end)) < end)
+            p += 4;
+    });
+
+    suite.run("obs_parse_avc_packet_64k", 10000, src->data->size(), [&] {
+        auto out = obs_parse_avc_packet(src);
+        (void)out;
+    });
+}
+
+/* drives lite_obs_output::interleave_packets through the real encoder
+ * callback path: two bench encoders paired on a null_output */
+static void bench_interleave(bench_suite &suite)
+{
+    if (!suite.enabled("interleave_packets"))
+        return;
+
+    auto output = std::make_shared<null_output>();
+    auto venc = std::make_shared<bench_encoder>(obs_encoder_type::OBS_ENCODER_VIDEO);
+    auto aenc = std::make_shared<bench_encoder>(obs_encoder_type::OBS_ENCODER_AUDIO);
+
+    output->lite_obs_output_create();
+    output->lite_obs_output_set_video_encoder(venc);
+    output->lite_obs_output_set_audio_encoder(aenc, 0);
+    venc->obs_encoder_initialize();
+    aenc->obs_encoder_initialize();
+
+    if (!output->lite_obs_output_begin_data_capture()) {
+        blog(LOG_WARNING, "bench: failed to begin data capture");
+        return;
+    }
+
+    auto payload = std::make_shared<std::vector<uint8_t>>();
+    bench_make_avc_access_unit(*payload, 4096, true, 0);
+
+    /* 30fps video, 1024 sample audio packets at 48khz */
+    int64_t video_idx = 0;
+    int64_t audio_pts = 0;
+    auto send = [&](std::shared_ptr<bench_encoder> enc, obs_encoder_type type, int64_t pts, int32_t den, bool key) {
+        auto pkt = std::make_shared<encoder_packet>();
+        pkt->data = payload;
+        pkt->type = type;
+        pkt->pts = pts;
+        pkt->dts = pts;
+        pkt->timebase_num = 1;
+        pkt->timebase_den = den;
+        pkt->keyframe = key;
+        pkt->encoder = enc;
+        enc->send_off_encoder_packet(true, true, pkt);
+    };
+
+    suite.run("interleave_packets_av", 50000, 0, [&] {
+        send(venc, obs_encoder_type::OBS_ENCODER_VIDEO, video_idx, 30, video_idx % 60 == 0);
+        video_idx++;
+
+        while (audio_pts * 30 < video_idx * 48000) {
+            send(aenc, obs_encoder_type::OBS_ENCODER_AUDIO, audio_pts, 48000, true);
+            audio_pts += 1024;
+        }
+    });
+
+    output->lite_obs_output_end_data_capture();
+    output->lite_obs_output_destroy();
+}
+
+void bench_register_micro(bench_suite &suite)
+{
+    bench_circlebuf(suite);
+
+    std::vector<uint8_t> yuv;
+    if (bench_load_yuv(suite.yuv_path(), yuv, BENCH_I420_SIZE)) {
+        bench_scaler(suite, yuv);
+        bench_converted_plane(suite, yuv);
+    }
+
+    bench_audio(suite);
+    bench_avc(suite);
+    bench_interleave(suite);
+}
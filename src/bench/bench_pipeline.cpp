@@ -0,0 +1,137 @@
+#include "lite_obs_bench.h"
+#include "bench_encoder.h"
+#include "util/threading.h"
+#include "util/log.h"
+#include "media-io/video_output.h"
+#include "output/null_output.h"
+
+#include <atomic>
+#include <thread>
+#include <string.h>
+
+#define BENCH_WIDTH 640
+#define BENCH_HEIGHT 360
+#define BENCH_I420_SIZE (BENCH_WIDTH * BENCH_HEIGHT * 3 / 2)
+
+struct pipeline_state {
+    std::shared_ptr<null_output> output;
+    std::atomic<uint64_t> cur_timestamp{};
+    std::vector<uint64_t> latencies;
+    std::atomic<uint64_t> packets{};
+};
+
+/* connected ahead of the encoder, records which frame the video thread is
+ * about to hand out so the encoder side can compute its latency */
+static void probe_video(void *param, video_data *frame)
+{
+    auto state = (pipeline_state *)param;
+    state->cur_timestamp.store(frame->timestamp, std::memory_order_relaxed);
+}
+
+static void receive_packet(void *param, std::shared_ptr<encoder_packet> packet)
+{
+    auto state = (pipeline_state *)param;
+    state->output->i_encoded_packet(packet);
+    state->packets++;
+}
+
+/* raw frames -> video_output (optionally scaling per input) -> encoder ->
+ * null_output, frames are pushed as fast as the output cache accepts them */
+static void bench_video_pipeline(bench_suite &suite, const char *name, const std::vector<uint8_t> &yuv, video_format encoder_format, size_t frames)
+{
+    if (!suite.enabled(name))
+        return;
+
+    frames = suite.scaled(frames);
+
+    video_output_info voi{};
+    voi.name = "bench";
+    voi.format = video_format::VIDEO_FORMAT_I420;
+    voi.fps_num = 30;
+    voi.fps_den = 1;
+    voi.width = BENCH_WIDTH;
+    voi.height = BENCH_HEIGHT;
+    voi.cache_size = 6;
+
+    auto video = std::make_shared<video_output>();
+    if (video->video_output_open(&voi) != VIDEO_OUTPUT_SUCCESS) {
+        blog(LOG_WARNING, "bench: failed to open video output");
+        return;
+    }
+
+    pipeline_state state;
+    state.output = std::make_shared<null_output>();
+    state.output->i_create();
+    state.latencies.reserve(frames);
+
+    auto encoder = std::make_shared<bench_encoder>(obs_encoder_type::OBS_ENCODER_VIDEO, encoder_format);
+    encoder->on_frame = [&state](encoder_frame *) {
+        uint64_t ts = state.cur_timestamp.load(std::memory_order_relaxed);
+        state.latencies.push_back(os_gettime_ns() - ts);
+    };
+    encoder->lite_obs_encoder_set_video(video);
+
+    video->video_output_connect(nullptr, probe_video, &state);
+    encoder->obs_encoder_initialize();
+    encoder->obs_encoder_start(receive_packet, &state);
+
+    const uint64_t max_queued = voi.cache_size / 2;
+    uint64_t pushed = 0;
+    uint64_t start = os_gettime_ns();
+    bool stalled = false;
+    for (size_t i = 0; i < frames && !stalled; i++) {
+        video_frame frame;
+
+        /* stay within the cache, a failed lock counts as a repeated frame */
+        uint64_t wait_start = os_gettime_ns();
+        while (pushed - state.packets >= max_queued) {
+            if (os_gettime_ns() - wait_start > 1000000000ULL) {
+                stalled = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+        if (stalled)
+            break;
+
+        if (!video->video_output_lock_frame(&frame, 1, os_gettime_ns()))
+            continue;
+
+        const uint8_t *src = yuv.data();
+        memcpy(frame.data[0], src, BENCH_WIDTH * BENCH_HEIGHT);
+        src += BENCH_WIDTH * BENCH_HEIGHT;
+        memcpy(frame.data[1], src, BENCH_WIDTH * BENCH_HEIGHT / 4);
+        src += BENCH_WIDTH * BENCH_HEIGHT / 4;
+        memcpy(frame.data[2], src, BENCH_WIDTH * BENCH_HEIGHT / 4);
+
+        video->video_output_unlock_frame();
+        pushed++;
+    }
+
+    /* wait for the video thread to drain the cache, frames whose lock
+     * failed never produce a packet */
+    uint64_t deadline = os_gettime_ns() + 5000000000ULL;
+    while (!stalled && state.packets < pushed && (uint64_t)os_gettime_ns() < deadline)
+        std::this_thread::yield();
+    uint64_t total = os_gettime_ns() - start;
+
+    encoder->obs_encoder_stop(receive_packet, &state);
+    video->video_output_disconnect(probe_video, &state);
+    video->video_output_close();
+
+    if (state.packets < pushed)
+        blog(LOG_WARNING, "bench: %s received %llu/%llu packets", name, (unsigned long long)state.packets.load(),
+             (unsigned long long)pushed);
+
+    suite.add(name, state.latencies, total, BENCH_I420_SIZE);
+}
+
+void bench_register_pipeline(bench_suite &suite)
+{
+    std::vector<uint8_t> yuv;
+    if (!bench_load_yuv(suite.yuv_path(), yuv, BENCH_I420_SIZE))
+        return;
+
+    bench_video_pipeline(suite, "pipeline_i420_encoder_null_output", yuv, video_format::VIDEO_FORMAT_I420, 3000);
+    bench_video_pipeline(suite, "pipeline_i420_scaled_nv12_encoder_null_output", yuv, video_format::VIDEO_FORMAT_NV12, 3000);
+}
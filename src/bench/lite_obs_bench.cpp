@@ -0,0 +1,185 @@
+#include "lite_obs_bench.h"
+#include "util/threading.h"
+#include "util/log.h"
+#include "util/trace.h"
+
+#include <algorithm>
+#include <string.h>
+#include <stdlib.h>
+
+#ifndef LITEOBS_BENCH_YUV
+#define LITEOBS_BENCH_YUV "640-360-420.yuv"
+#endif
+
+bench_suite::bench_suite(const std::string &filter, double scale, const std::string &yuv_path)
+    : filter(filter), iteration_scale(scale), yuv(yuv_path)
+{
+}
+
+bool bench_suite::enabled(const char *name) const
+{
+    return filter.empty() || strstr(name, filter.c_str()) != nullptr;
+}
+
+size_t bench_suite::scaled(size_t iterations) const
+{
+    size_t n = (size_t)((double)iterations * iteration_scale);
+    return n ? n : 1;
+}
+
+void bench_suite::run(const char *name, size_t iterations, size_t bytes_per_iter, const std::function<void()> &fn)
+{
+    if (!enabled(name))
+        return;
+
+    iterations = scaled(iterations);
+
+    for (size_t i = 0; i < iterations / 10 + 1; i++)
+        fn();
+
+    std::vector<uint64_t> samples(iterations);
+    uint64_t start = os_gettime_ns();
+    for (size_t i = 0; i < iterations; i++) {
+        uint64_t t = os_gettime_ns();
+        fn();
+        samples[i] = os_gettime_ns() - t;
+    }
+    uint64_t total = os_gettime_ns() - start;
+
+    add(name, samples, total, bytes_per_iter);
+}
+
+void bench_suite::add(const char *name, std::vector<uint64_t> &samples_ns, uint64_t total_ns, size_t bytes_per_iter)
+{
+    if (samples_ns.empty())
+        return;
+
+    std::sort(samples_ns.begin(), samples_ns.end());
+
+    bench_result r;
+    r.name = name;
+    r.iterations = samples_ns.size();
+    r.total_ns = total_ns;
+    r.bytes_per_iter = (double)bytes_per_iter;
+    r.min_ns = samples_ns.front();
+    r.max_ns = samples_ns.back();
+    r.p50_ns = samples_ns[(samples_ns.size() - 1) * 50 / 100];
+    r.p99_ns = samples_ns[(samples_ns.size() - 1) * 99 / 100];
+
+    double sum = 0.0;
+    for (auto s : samples_ns)
+        sum += (double)s;
+    r.mean_ns = sum / (double)samples_ns.size();
+
+    fprintf(stderr, "%-40s %10llu iters  p50 %10llu ns  p99 %10llu ns\n", name,
+            (unsigned long long)r.iterations, (unsigned long long)r.p50_ns,
+            (unsigned long long)r.p99_ns);
+
+    results.push_back(std::move(r));
+}
+
+void bench_suite::write_json(FILE *f) const
+{
+    fprintf(f, "{\n  \"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); i++) {
+        auto &r = results[i];
+        double secs = (double)r.total_ns / 1e9;
+        double ops = secs > 0.0 ? (double)r.iterations / secs : 0.0;
+        double mbps = ops * r.bytes_per_iter / (1024.0 * 1024.0);
+
+        fprintf(f,
+                "    {\"name\": \"%s\", \"iterations\": %llu, \"total_ns\": %llu, "
+                "\"ops_per_sec\": %.3f, \"mb_per_sec\": %.3f, "
+                "\"min_ns\": %llu, \"p50_ns\": %llu, \"p99_ns\": %llu, "
+                "\"max_ns\": %llu, \"mean_ns\": %.1f}%s\n",
+                r.name.c_str(), (unsigned long long)r.iterations,
+                (unsigned long long)r.total_ns, ops, mbps,
+                (unsigned long long)r.min_ns, (unsigned long long)r.p50_ns,
+                (unsigned long long)r.p99_ns, (unsigned long long)r.max_ns,
+                r.mean_ns, i + 1 == results.size() ? "" : ",");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+bool bench_load_yuv(const std::string &path, std::vector<uint8_t> &data, size_t expected_size)
+{
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) {
+        blog(LOG_ERROR, "bench: failed to open '%s'", path.c_str());
+        return false;
+    }
+
+    data.resize(expected_size);
+    size_t read = fread(data.data(), 1, expected_size, f);
+    fclose(f);
+
+    if (read != expected_size) {
+        blog(LOG_ERROR, "bench: '%s' is %zu bytes, expected %zu", path.c_str(), read, expected_size);
+        return false;
+    }
+
+    return true;
+}
+
+static void print_usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--filter <substr>] [--scale <factor>] [--yuv <file>] [--out <file.json>] [--trace <file.json>]\n"
+            "  --filter  only run benchmarks whose name contains <substr>\n"
+            "  --scale   multiply iteration counts (default 1.0)\n"
+            "  --yuv     640x360 I420 input clip (default %s)\n"
+            "  --out     write json results to a file instead of stdout\n"
+            "  --trace   dump recorded trace spans (LITEOBS_ENABLE_TRACE builds)\n",
+            argv0, LITEOBS_BENCH_YUV);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string filter;
+    std::string yuv = LITEOBS_BENCH_YUV;
+    const char *out_path = nullptr;
+    const char *trace_path = nullptr;
+    double scale = 1.0;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--filter") == 0 && has_value) {
+            filter = argv[++i];
+        } else if (strcmp(argv[i], "--scale") == 0 && has_value) {
+            scale = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--yuv") == 0 && has_value) {
+            yuv = argv[++i];
+        } else if (strcmp(argv[i], "--out") == 0 && has_value) {
+            out_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && has_value) {
+            trace_path = argv[++i];
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    blog_set_level(LOG_WARNING);
+
+    bench_suite suite(filter, scale > 0.0 ? scale : 1.0, yuv);
+    bench_register_micro(suite);
+    bench_register_pipeline(suite);
+
+    blog_flush();
+
+    if (trace_path)
+        trace_dump_json(trace_path);
+
+    FILE *out = out_path ? fopen(out_path, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "failed to open '%s'\n", out_path);
+        return 1;
+    }
+
+    suite.write_json(out);
+
+    if (out != stdout)
+        fclose(out);
+
+    return 0;
+}
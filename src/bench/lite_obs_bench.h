@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct bench_result {
+    std::string name;
+    uint64_t iterations{};
+    uint64_t total_ns{};
+    double bytes_per_iter{};
+    uint64_t min_ns{};
+    uint64_t p50_ns{};
+    uint64_t p99_ns{};
+    uint64_t max_ns{};
+    double mean_ns{};
+};
+
+class bench_suite
+{
+public:
+    bench_suite(const std::string &filter, double scale, const std::string &yuv_path);
+
+    const std::string &yuv_path() const { return yuv; }
+
+    bool enabled(const char *name) const;
+    size_t scaled(size_t iterations) const;
+
+    /* times every call of fn individually, after a short warmup */
+    void run(const char *name, size_t iterations, size_t bytes_per_iter, const std::function<void()> &fn);
+
+    /* for benchmarks that measure latency themselves (e.g. across threads) */
+    void add(const char *name, std::vector<uint64_t> &samples_ns, uint64_t total_ns, size_t bytes_per_iter);
+
+    void write_json(FILE *f) const;
+
+private:
+    std::string filter;
+    double iteration_scale{1.0};
+    std::string yuv;
+    std::vector<bench_result> results;
+};
+
+bool bench_load_yuv(const std::string &path, std::vector<uint8_t> &data, size_t expected_size);
+
+void bench_register_micro(bench_suite &suite);
+void bench_register_pipeline(bench_suite &suite);
@@ -1,5 +1,8 @@
 #include "gl-helpers.h"
 #include <memory>
+#include <string.h>
+
+uint64_t gl_call_count = 0;
 
 bool gl_init_face(GLenum target, GLenum type, uint32_t num_levels,
           GLenum format, GLint internal_format, bool compressed,
@@ -152,3 +155,34 @@ bool update_buffer(GLenum target, GLuint buffer, const void *data, size_t size)
     gl_bind_buffer(target, 0);
     return success;
 }
+
+gl_buffer_storage_t gl_buffer_storage = nullptr;
+
+#if defined __ANDROID__ || defined __linux__
+static bool gl_has_extension(const char *name)
+{
+    GLint count = 0;
+    if (!gl_get_integer_v(GL_NUM_EXTENSIONS, &count))
+        return false;
+
+    for (GLint i = 0; i < count; i++) {
+        const char *ext = (const char *)glGetStringi(GL_EXTENSIONS, i);
+        if (ext && strcmp(ext, name) == 0)
+            return true;
+    }
+
+    return false;
+}
+#endif
+
+bool gl_load_buffer_storage()
+{
+    gl_buffer_storage = nullptr;
+
+#if defined __ANDROID__ || defined __linux__
+    if (gl_has_extension("GL_EXT_buffer_storage"))
+        gl_buffer_storage = (gl_buffer_storage_t)eglGetProcAddress("glBufferStorageEXT");
+#endif
+
+    return gl_buffer_storage != nullptr;
+}
@@ -3,6 +3,10 @@
 #include "gs_subsystem_info.h"
 #include "util/log.h"
 
+/* GL calls issued so far, counted by gl_success which follows nearly every
+ * call.  Only touched with the graphics context entered */
+extern uint64_t gl_call_count;
+
 static const char *gl_error_to_str(GLenum errorcode)
 {
 	static const struct {
@@ -45,6 +49,8 @@ static const char *gl_error_to_str(GLenum errorcode)
 
 static inline bool gl_success(const char *funcname)
 {
+	gl_call_count++;
+
 	GLenum errorcode = glGetError();
 	if (errorcode != GL_NO_ERROR) {
 		int attempts = 8;
@@ -189,3 +195,15 @@ bool gl_create_buffer(GLenum target, GLuint *buffer, GLsizeiptr size,
                  const GLvoid *data, GLenum usage);
 
 bool update_buffer(GLenum target, GLuint buffer, const void *data, size_t size);
+
+#ifndef GL_MAP_PERSISTENT_BIT_EXT
+#define GL_MAP_PERSISTENT_BIT_EXT 0x0040
+#define GL_MAP_COHERENT_BIT_EXT 0x0080
+#endif
+
+/* glBufferStorageEXT (GL_EXT_buffer_storage), loaded by the device once its
+ * context is current and NULL when persistent mapping is unavailable */
+typedef void (*gl_buffer_storage_t)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+extern gl_buffer_storage_t gl_buffer_storage;
+
+bool gl_load_buffer_storage();
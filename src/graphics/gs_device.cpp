@@ -9,6 +9,7 @@
 #include "gs_vertexbuffer.h"
 
 #include <glm/mat4x4.hpp>
+#include <list>
 
 struct gs_device_private
 {
@@ -16,7 +17,8 @@ struct gs_device_private
 
     GLuint empty_vao{};
 
-    std::weak_ptr<gs_texture> cur_render_target{};
+    std::weak_ptr<gs_texture> cur_render_targets[GS_MAX_RENDER_TARGETS]{};
+    uint32_t cur_num_render_targets{};
     std::weak_ptr<gs_zstencil_buffer> cur_zstencil_buffer{};
     std::weak_ptr<fbo_info> cur_fbo{};
 
@@ -37,6 +39,21 @@ struct gs_device_private
 
     std::list<glm::mat4x4> proj_stack{};
 
+    /* what is actually set in GL, calls that would not change it are
+     * skipped.  Textures stay bound after a technique ends and uploads
+     * bind on the spare unit past the ones effects sample from */
+    std::weak_ptr<gs_program> gl_program{};
+    GLuint gl_vao{};
+    std::weak_ptr<gs_texture> gl_textures[GS_MAX_TEXTURES]{};
+    GLenum gl_active_unit{GS_MAX_TEXTURES};
+    GLenum gl_front_face{GL_CCW};
+    struct gs_rect gl_viewport{0, 0, -1, -1};
+    bool gl_scissor{};
+    struct gs_rect gl_scissor_rect{0, 0, -1, -1};
+    bool gl_blend{};
+    GLenum gl_blend_func[4]{};
+    bool gl_depth_test{};
+
     gs_device_private() {
         cur_textures.resize(GS_MAX_TEXTURES);
         cur_samplers.resize(GS_MAX_TEXTURES);
@@ -83,8 +100,14 @@ int gs_device::device_create()
 
     blog(LOG_INFO, "OpenGL loaded successfully, version %s, shading " "language %s", glVersion, glShadingLanguage);
 
+    if (gl_load_buffer_storage())
+        blog(LOG_INFO, "Dynamic textures upload through persistent mapped buffers");
+    else
+        blog(LOG_INFO, "Dynamic textures upload through unsynchronized buffer maps");
+
     gl_enable(GL_CULL_FACE);
     gl_gen_vertex_arrays(1, &d_ptr->empty_vao);
+    gl_active_texture(GL_TEXTURE0 + d_ptr->gl_active_unit);
 
     device_leave_context();
 
@@ -122,9 +145,38 @@ void gs_device::device_blend_function_separate(gs_blend_type src_c, gs_blend_typ
     GLenum gl_src_a = convert_gs_blend_type(src_a);
     GLenum gl_dst_a = convert_gs_blend_type(dest_a);
 
+    GLenum *cur = d_ptr->gl_blend_func;
+    if (cur[0] == gl_src_c && cur[1] == gl_dst_c && cur[2] == gl_src_a && cur[3] == gl_dst_a)
+        return;
+
     glBlendFuncSeparate(gl_src_c, gl_dst_c, gl_src_a, gl_dst_a);
-    if (!gl_success("glBlendFuncSeparate"))
+    if (!gl_success("glBlendFuncSeparate")) {
         blog(LOG_ERROR, "device_blend_function_separate (GL) failed");
+        return;
+    }
+
+    cur[0] = gl_src_c;
+    cur[1] = gl_dst_c;
+    cur[2] = gl_src_a;
+    cur[3] = gl_dst_a;
+}
+
+void gs_device::device_enable_blending(bool enable)
+{
+    if (d_ptr->gl_blend == enable)
+        return;
+
+    if (enable ? gl_enable(GL_BLEND) : gl_disable(GL_BLEND))
+        d_ptr->gl_blend = enable;
+}
+
+void gs_device::device_enable_depth_test(bool enable)
+{
+    if (d_ptr->gl_depth_test == enable)
+        return;
+
+    if (enable ? gl_enable(GL_DEPTH_TEST) : gl_disable(GL_DEPTH_TEST))
+        d_ptr->gl_depth_test = enable;
 }
 
 
@@ -136,10 +188,8 @@ bool gs_device::set_current_fbo(std::shared_ptr<fbo_info> fbo)
         if (!gl_bind_framebuffer(GL_FRAMEBUFFER, fbo_obj))
             return false;
 
-        if (cur_fbo) {
-            cur_fbo->cur_render_target.reset();
-            cur_fbo->cur_zstencil_buffer.reset();
-        }
+        if (cur_fbo)
+            cur_fbo->reset_attachments();
     }
 
     d_ptr->cur_fbo = fbo;
@@ -148,7 +198,7 @@ bool gs_device::set_current_fbo(std::shared_ptr<fbo_info> fbo)
 
 uint32_t gs_device::get_target_height()
 {
-    auto render_target = d_ptr->cur_render_target.lock();
+    auto render_target = d_ptr->cur_render_targets[0].lock();
     if (!render_target) {
         blog(LOG_DEBUG, "get_target_height (GL): no cur target");
         return 0;
@@ -164,7 +214,7 @@ bool gs_device::can_render(uint32_t num_verts)
         return false;
     }
 
-    if (!d_ptr->cur_render_target.lock()) {
+    if (!d_ptr->cur_render_targets[0].lock()) {
         blog(LOG_ERROR, "No active swap chain or render target");
         return false;
     }
@@ -178,53 +228,81 @@ void gs_device::update_viewproj_matrix()
     if (!program)
         return;
 
-    auto vs = program->gs_effect_vertex_shader();
     glm::mat4x4 cur_proj{0};
 
     gs_matrix_get(d_ptr->cur_view);
     cur_proj = d_ptr->cur_proj;
 
+    GLenum front_face = GL_CCW;
     if (d_ptr->cur_fbo.lock()) {
         cur_proj[0][1] = -cur_proj[0][1];
         cur_proj[1][1] = -cur_proj[1][1];
         cur_proj[2][1] = -cur_proj[2][1];
         cur_proj[3][1] = -cur_proj[3][1];
 
-        glFrontFace(GL_CW);
-    } else {
-        glFrontFace(GL_CCW);
+        front_face = GL_CW;
     }
 
-    gl_success("glFrontFace");
+    if (d_ptr->gl_front_face != front_face) {
+        glFrontFace(front_face);
+        if (gl_success("glFrontFace"))
+            d_ptr->gl_front_face = front_face;
+    }
 
     d_ptr->cur_viewproj = d_ptr->cur_view * cur_proj;
     d_ptr->cur_viewproj = glm::transpose(d_ptr->cur_viewproj);
 
-    vs->gs_shader_set_matrix4(d_ptr->cur_viewproj);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_VIEWPROJ, d_ptr->cur_viewproj);
 }
 
 bool gs_device::gs_device_set_render_target(std::shared_ptr<gs_texture> tex, std::shared_ptr<gs_zstencil_buffer> zs)
 {
-    auto cur_render_target = d_ptr->cur_render_target.lock();
-    auto cur_zstencil_buffer = d_ptr->cur_zstencil_buffer.lock();
+    return gs_device_set_render_targets(&tex, tex ? 1 : 0, zs);
+}
+
+bool gs_device::gs_device_set_render_targets(const std::shared_ptr<gs_texture> *textures, uint32_t count, std::shared_ptr<gs_zstencil_buffer> zs)
+{
+    if (count > GS_MAX_RENDER_TARGETS)
+        return false;
 
-    if (cur_render_target == tex && cur_zstencil_buffer == zs)
+    bool changed = count != d_ptr->cur_num_render_targets || d_ptr->cur_zstencil_buffer.lock() != zs;
+    for (uint32_t i = 0; i < count && !changed; i++)
+        changed = d_ptr->cur_render_targets[i].lock() != textures[i];
+
+    if (!changed)
         return true;
 
-    d_ptr->cur_render_target = tex;
+    /* a texture left bound from earlier draws must not stay bound while
+     * it is rendered to */
+    for (uint32_t i = 0; i < count; i++) {
+        for (GLenum unit = 0; unit < GS_MAX_TEXTURES; unit++) {
+            if (!textures[i] || d_ptr->gl_textures[unit].lock() != textures[i])
+                continue;
+
+            set_active_texture_unit(unit);
+            gl_bind_texture(textures[i]->gs_texture_target(), 0);
+            d_ptr->gl_textures[unit].reset();
+        }
+    }
+
+    for (uint32_t i = 0; i < GS_MAX_RENDER_TARGETS; i++)
+        d_ptr->cur_render_targets[i] = i < count ? textures[i] : nullptr;
+    d_ptr->cur_num_render_targets = count;
     d_ptr->cur_zstencil_buffer = zs;
 
-    if (!tex) {
+    if (!count) {
         return set_current_fbo(nullptr);
     }
 
-    auto fbo = tex->get_fbo();
+    /* all targets share the fbo of the first one, gl limits the drawn
+     * area to the smallest attachment */
+    auto fbo = textures[0]->get_fbo();
     if (!fbo)
         return false;
 
     set_current_fbo(fbo);
 
-    if (!fbo->attach_rendertarget(tex))
+    if (!fbo->attach_rendertargets(textures, count))
         return false;
     if (!fbo->attach_zstencil(zs))
         return false;
@@ -280,9 +358,14 @@ void gs_device::gs_device_set_viewport(int x, int y, int width, int height)
     if (base_height)
         gl_y = base_height - y - height;
 
-    glViewport(x, gl_y, width, height);
-    if (!gl_success("glViewport"))
-        blog(LOG_ERROR, "device_set_viewport (GL) failed");
+    auto &gl_rect = d_ptr->gl_viewport;
+    if (gl_rect.x != x || gl_rect.y != gl_y || gl_rect.cx != width || gl_rect.cy != height) {
+        glViewport(x, gl_y, width, height);
+        if (gl_success("glViewport"))
+            gl_rect = {x, gl_y, width, height};
+        else
+            blog(LOG_ERROR, "device_set_viewport (GL) failed");
+    }
 
     d_ptr->cur_viewport.x = x;
     d_ptr->cur_viewport.y = y;
@@ -295,6 +378,33 @@ void gs_device::gs_device_get_viewport(gs_rect &rect)
     rect = d_ptr->cur_viewport;
 }
 
+void gs_device::gs_device_set_scissor_rect(const gs_rect *rect)
+{
+    if (!rect) {
+        if (d_ptr->gl_scissor && gl_disable(GL_SCISSOR_TEST))
+            d_ptr->gl_scissor = false;
+        return;
+    }
+
+    /* canvas rows map straight onto render target rows, the projection
+     * already flips them */
+    if (!d_ptr->gl_scissor) {
+        if (!gl_enable(GL_SCISSOR_TEST))
+            return;
+        d_ptr->gl_scissor = true;
+    }
+
+    auto &gl_rect = d_ptr->gl_scissor_rect;
+    if (gl_rect.x == rect->x && gl_rect.y == rect->y && gl_rect.cx == rect->cx && gl_rect.cy == rect->cy)
+        return;
+
+    glScissor(rect->x, rect->y, rect->cx, rect->cy);
+    if (gl_success("glScissor"))
+        gl_rect = *rect;
+    else
+        blog(LOG_ERROR, "device_set_scissor_rect (GL) failed");
+}
+
 void gs_device::gs_device_projection_push()
 {
     d_ptr->proj_stack.push_back(d_ptr->cur_proj);
@@ -311,7 +421,7 @@ void gs_device::gs_device_projection_pop()
 
 std::shared_ptr<gs_texture> gs_device::gs_device_get_render_target()
 {
-    return d_ptr->cur_render_target.lock();
+    return d_ptr->cur_render_targets[0].lock();
 }
 
 std::shared_ptr<gs_zstencil_buffer> gs_device::gs_device_get_zstencil_target()
@@ -331,20 +441,16 @@ void gs_device::gs_device_load_indexbuffer(std::shared_ptr<gs_indexbuffer> ib)
 
 void gs_device::gs_device_set_program(std::shared_ptr<gs_program> program)
 {
-    std::shared_ptr<gs_program> cur_program = d_ptr->cur_program.lock();
+    d_ptr->cur_program = program;
 
-    if (program != cur_program && cur_program) {
-        glUseProgram(0);
-        gl_success("glUseProgram (zero)");
-    }
+    /* the last program stays in use after its technique ends, the next
+     * technique with the same effect then needs no switch at all */
+    if (!program || d_ptr->gl_program.lock() == program)
+        return;
 
-    if (program != cur_program) {
-        d_ptr->cur_program = program;
-        if (program) {
-            glUseProgram(program->gs_effect_obj());
-            gl_success("glUseProgram");
-        }
-    }
+    glUseProgram(program->gs_effect_obj());
+    if (gl_success("glUseProgram"))
+        d_ptr->gl_program = program;
 }
 
 std::shared_ptr<gs_program> gs_device::gs_device_program()
@@ -369,18 +475,13 @@ void gs_device::gs_device_draw(gs_draw_mode draw_mode, uint32_t start_vert, uint
         goto fail;
 
     if (vb) {
-        if (!gl_bind_vertex_array(vb->gs_vertexbuffer_vao()))
+        if (!bind_vertex_array(vb->gs_vertexbuffer_vao(program)))
             goto fail;
-        auto attribs = program->gs_effect_vertex_shader()->gs_shader_attribs();
-        auto s_attribs = program->gs_effect_attribs();
-        for (int i = 0; i < attribs.size(); ++i) {
-            vb->gs_load_vb_buffers(attribs[i].type, attribs[i].index, s_attribs[i]);
-        }
         // todo indexbuffer
         //        if (ib && !gl_bind_buffer(GL_ELEMENT_ARRAY_BUFFER, ib->buffer))
         //            goto fail;
-    } else
-        gl_bind_vertex_array(d_ptr->empty_vao);
+    } else if (!bind_vertex_array(d_ptr->empty_vao))
+        goto fail;
 
 
     update_viewproj_matrix();
@@ -414,18 +515,11 @@ void gs_device::gs_device_load_texture(std::weak_ptr<gs_texture> p_tex, int unit
     std::shared_ptr<gs_sampler_state> sampler;
     std::shared_ptr<gs_program> program;
     std::shared_ptr<gs_shader_param> param;
+    std::shared_ptr<gs_texture> gl_tex;
     auto cur_tex = d_ptr->cur_textures[unit].lock();
     auto tex = p_tex.lock();
     if (cur_tex == tex)
-        goto fail;
-
-    if (!gl_active_texture(GL_TEXTURE0 + unit))
-        goto fail;
-
-    /* the target for the previous text may not be the same as the
-         * next texture, so unbind the previous texture first to be safe */
-    if (cur_tex && (!tex || cur_tex->gs_texture_target() != tex->gs_texture_target()))
-        gl_bind_texture(cur_tex->gs_texture_target(), 0);
+        return;
 
     d_ptr->cur_textures[unit] = p_tex;
 
@@ -446,10 +540,27 @@ void gs_device::gs_device_load_texture(std::weak_ptr<gs_texture> p_tex, int unit
     else
         sampler = nullptr;
 
-    if (!gl_bind_texture(tex->gs_texture_target(), tex->gs_texture_obj()))
-        goto fail;
-    if (sampler && !tex->gs_texture_load_texture_sampler(sampler))
-        goto fail;
+    gl_tex = d_ptr->gl_textures[unit].lock();
+    if (gl_tex != tex) {
+        if (!set_active_texture_unit(unit))
+            goto fail;
+
+        /* the target for the previous texture may not be the same as the
+         * next texture, so unbind the previous texture first to be safe */
+        if (gl_tex && gl_tex->gs_texture_target() != tex->gs_texture_target())
+            gl_bind_texture(gl_tex->gs_texture_target(), 0);
+
+        if (!gl_bind_texture(tex->gs_texture_target(), tex->gs_texture_obj()))
+            goto fail;
+        d_ptr->gl_textures[unit] = tex;
+    }
+
+    if (sampler && !tex->gs_texture_sampler_loaded(sampler)) {
+        if (!set_active_texture_unit(unit))
+            goto fail;
+        if (!tex->gs_texture_load_texture_sampler(sampler))
+            goto fail;
+    }
 
     return;
 
@@ -459,15 +570,40 @@ fail:
 
 void gs_device::gs_device_clear_textures()
 {
-    GLenum i;
-    for (i = 0; i < GS_MAX_TEXTURES; i++) {
-        auto tex = d_ptr->cur_textures[i].lock();
-        if (tex) {
-            gl_active_texture(GL_TEXTURE0 + i);
-            gl_bind_texture(tex->gs_texture_target(), 0);
-            d_ptr->cur_textures[i].reset();
-        }
-    }
+    for (GLenum i = 0; i < GS_MAX_TEXTURES; i++)
+        d_ptr->cur_textures[i].reset();
+
+    /* the textures stay bound in gl for the next technique, uploads in
+     * between bind on the spare unit and leave them alone */
+    set_active_texture_unit(GS_MAX_TEXTURES);
+}
+
+bool gs_device::set_active_texture_unit(GLenum unit)
+{
+    if (d_ptr->gl_active_unit == unit)
+        return true;
+
+    if (!gl_active_texture(GL_TEXTURE0 + unit))
+        return false;
+
+    d_ptr->gl_active_unit = unit;
+    return true;
+}
+
+bool gs_device::bind_vertex_array(GLuint vao)
+{
+    /* a vertex array is bound when it is configured, so a name reused
+     * after the bound one was deleted is bound as well */
+    if (!vao)
+        return false;
+    if (d_ptr->gl_vao == vao)
+        return true;
+
+    if (!gl_bind_vertex_array(vao))
+        return false;
+
+    d_ptr->gl_vao = vao;
+    return true;
 }
 
 void gs_device::gs_device_load_default_pixelshader_samplers()
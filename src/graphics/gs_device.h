@@ -26,13 +26,17 @@ public:
     void device_leave_context();
 
     void device_blend_function_separate(gs_blend_type src_c, gs_blend_type dest_c, gs_blend_type src_a, gs_blend_type dest_a);
+    void device_enable_blending(bool enable);
+    void device_enable_depth_test(bool enable);
 
     bool gs_device_set_render_target(std::shared_ptr<gs_texture> tex, std::shared_ptr<gs_zstencil_buffer> zs);
+    bool gs_device_set_render_targets(const std::shared_ptr<gs_texture> *textures, uint32_t count, std::shared_ptr<gs_zstencil_buffer> zs);
     void gs_device_set_cull_mode(gs_cull_mode mode);
 
     void gs_device_ortho(float left, float right, float top, float bottom, float near, float far);
     void gs_device_set_viewport(int x, int y, int width, int height);
     void gs_device_get_viewport(gs_rect &rect);
+    void gs_device_set_scissor_rect(const gs_rect *rect);
 
     void gs_device_projection_push();
     void gs_device_projection_pop();
@@ -62,6 +66,9 @@ private:
     bool set_current_fbo(std::shared_ptr<fbo_info> fbo);
     uint32_t get_target_height();
 
+    bool set_active_texture_unit(GLenum unit);
+    bool bind_vertex_array(GLuint vao);
+
     bool can_render(uint32_t num_verts);
     void update_viewproj_matrix();
 
@@ -0,0 +1,157 @@
+#include "gs_device.h"
+#include "util/log.h"
+
+#include <string.h>
+
+/* Headless EGL platform for servers: prefers the Mesa surfaceless platform
+ * (no X/Wayland needed), falls back to the default display with a small
+ * pbuffer when surfaceless contexts are not available. */
+struct gl_platform
+{
+    EGLDisplay display{EGL_NO_DISPLAY};
+    EGLSurface surface{EGL_NO_SURFACE};
+    EGLContext context{EGL_NO_CONTEXT};
+
+    ~gl_platform() {
+        if (display == EGL_NO_DISPLAY)
+            return;
+
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (context != EGL_NO_CONTEXT)
+            eglDestroyContext(display, context);
+        if (surface != EGL_NO_SURFACE)
+            eglDestroySurface(display, surface);
+        eglTerminate(display);
+    }
+};
+
+static bool egl_has_extension(const char *extensions, const char *name)
+{
+    if (!extensions)
+        return false;
+
+    size_t len = strlen(name);
+    const char *pos = extensions;
+    while ((pos = strstr(pos, name)) != nullptr) {
+        if ((pos == extensions || pos[-1] == ' ') && (pos[len] == ' ' || pos[len] == '\0'))
+            return true;
+        pos += len;
+    }
+
+    return false;
+}
+
+static EGLDisplay egl_get_headless_display()
+{
+    const char *client_exts = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (egl_has_extension(client_exts, "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display) {
+            EGLDisplay display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                blog(LOG_DEBUG, "using EGL surfaceless platform");
+                return display;
+            }
+        }
+    }
+
+    blog(LOG_DEBUG, "EGL surfaceless platform unavailable, using default display");
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+void *gs_device::gl_platform_create()
+{
+    const EGLint attribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 0,
+        EGL_STENCIL_SIZE, 0,
+        EGL_NONE
+    };
+    const EGLint pbuffer_attribs[] = {
+        EGL_WIDTH, 16,
+        EGL_HEIGHT, 16,
+        EGL_NONE
+    };
+    const EGLint context_attribs[] = {
+        EGL_CONTEXT_CLIENT_VERSION, 3,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint num_configs = 0;
+    EGLint major = 0, minor = 0;
+
+    blog(LOG_DEBUG, "Initializing context");
+
+    auto plat = std::make_unique<gl_platform>();
+
+    if ((plat->display = egl_get_headless_display()) == EGL_NO_DISPLAY) {
+        blog(LOG_ERROR, "eglGetDisplay() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    if (!eglInitialize(plat->display, &major, &minor)) {
+        blog(LOG_ERROR, "eglInitialize() returned error %d", eglGetError());
+        plat->display = EGL_NO_DISPLAY;
+        return nullptr;
+    }
+
+    blog(LOG_INFO, "EGL %d.%d initialized, vendor: %s", major, minor, eglQueryString(plat->display, EGL_VENDOR));
+
+    if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+        blog(LOG_ERROR, "eglBindAPI() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    if (!eglChooseConfig(plat->display, attribs, &config, 1, &num_configs) || num_configs == 0) {
+        blog(LOG_ERROR, "eglChooseConfig() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    if ((plat->context = eglCreateContext(plat->display, config, EGL_NO_CONTEXT, context_attribs)) == EGL_NO_CONTEXT) {
+        blog(LOG_ERROR, "eglCreateContext() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    const char *display_exts = eglQueryString(plat->display, EGL_EXTENSIONS);
+    if (!egl_has_extension(display_exts, "EGL_KHR_surfaceless_context")) {
+        if ((plat->surface = eglCreatePbufferSurface(plat->display, config, pbuffer_attribs)) == EGL_NO_SURFACE) {
+            blog(LOG_ERROR, "eglCreatePbufferSurface() returned error %d", eglGetError());
+            return nullptr;
+        }
+    }
+
+    if (!eglMakeCurrent(plat->display, plat->surface, plat->surface, plat->context)) {
+        blog(LOG_ERROR, "eglMakeCurrent() returned error %d", eglGetError());
+        return nullptr;
+    }
+
+    blog(LOG_DEBUG, "egl create headless opengles context success (%s)",
+         plat->surface == EGL_NO_SURFACE ? "surfaceless" : "pbuffer");
+
+    return plat.release();
+}
+
+void gs_device::device_enter_context_internal(void *param)
+{
+    gl_platform *plat = (gl_platform *)param;
+    if (!eglMakeCurrent(plat->display, plat->surface, plat->surface, plat->context)) {
+        blog(LOG_ERROR, "eglMakeCurrent() returned error %d", eglGetError());
+    }
+}
+
+void gs_device::device_leave_context_internal(void *param)
+{
+    gl_platform *plat = (gl_platform *)param;
+    eglMakeCurrent(plat->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+}
+
+void gs_device::gl_platform_destroy(void *plat)
+{
+    gl_platform *p = (gl_platform *)plat;
+    delete p;
+}
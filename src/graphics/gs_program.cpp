@@ -11,11 +11,48 @@
 
 #include <vector>
 
+typedef void (*param_upload_t)(GLint obj, const void *data);
+
+/* values live in the program's packed block at offset, dirty while gl
+ * does not have the one stored there yet */
 struct program_param {
     GLint obj{};
     std::shared_ptr<gs_shader_param> param{};
+    param_upload_t upload{};
+    size_t offset{};
+    size_t size{};
+    bool dirty{};
+};
+
+static const char *effect_param_names[] = {
+    "ViewProj",
+    "image",
+    "image0",
+    "image1",
+    "image2",
+    "image3",
+    "image4",
+    "image5",
+    "image6",
+    "image7",
+    "width",
+    "height",
+    "width_d2",
+    "height_d2",
+    "width_i",
+    "color_vec0",
+    "color_vec1",
+    "color_vec2",
+    "color_range_min",
+    "color_range_max",
+    "base_dimension",
+    "base_dimension_f",
+    "base_dimension_i",
 };
 
+static_assert(sizeof(effect_param_names) / sizeof(effect_param_names[0]) ==
+              (size_t)gs_effect_param_id::GS_PARAM_COUNT, "effect param names out of sync");
+
 struct gs_program_private
 {
     std::string name{};
@@ -24,6 +61,8 @@ struct gs_program_private
     std::shared_ptr<gs_shader> pixel_shader{};
 
     std::vector<program_param> params{};
+    std::vector<uint8_t> values{};
+    int known_params[(size_t)gs_effect_param_id::GS_PARAM_COUNT]{};
     std::vector<GLint> attribs{};
 
     ~gs_program_private() {
@@ -38,6 +77,8 @@ gs_program::gs_program(const std::string &name)
 {
     d_ptr = std::make_unique<gs_program_private>();
     d_ptr->name = name;
+    for (auto &index : d_ptr->known_params)
+        index = -1;
 }
 
 gs_program::~gs_program()
@@ -128,156 +169,224 @@ const std::string &gs_program::gs_program_name()
 
 void gs_program::gs_effect_set_texture(const char *name, std::shared_ptr<gs_texture> tex)
 {
-    auto p = gs_effect_get_param_by_name(name);
-    if (!p)
-        return;
-
-    p->param->texture = tex;
-    p->param->changed = true;
+    set_param_texture(gs_effect_get_param_by_name(name), tex);
 }
 
 void gs_program::gs_effect_set_param(const char *name, float value)
 {
-    auto p = gs_effect_get_param_by_name(name);
-    if (!p)
-        return;
-
-    p->param->cur_value.resize(sizeof(float));
-    memcpy(p->param->cur_value.data(), &value, sizeof(float));
-    p->param->changed = true;
+    set_param_value(gs_effect_get_param_by_name(name), &value, sizeof(float));
 }
 
 void gs_program::gs_effect_set_param(const char *name, const glm::vec4 &value)
 {
-    auto p = gs_effect_get_param_by_name(name);
-    if (!p)
-        return;
-
-    p->param->cur_value.resize(sizeof(glm::vec4));
-    memcpy(p->param->cur_value.data(), &value, sizeof(glm::vec4));
-    p->param->changed = true;
+    set_param_value(gs_effect_get_param_by_name(name), &value, sizeof(glm::vec4));
 }
 
 void gs_program::gs_effect_set_param(const char *name, const glm::vec2 &value)
 {
-    auto p = gs_effect_get_param_by_name(name);
-    if (!p)
-        return;
-
-    p->param->cur_value.resize(sizeof(glm::vec2));
-    memcpy(p->param->cur_value.data(), &value, sizeof(glm::vec2));
-    p->param->changed = true;
+    set_param_value(gs_effect_get_param_by_name(name), &value, sizeof(glm::vec2));
 }
 
 void gs_program::gs_effect_set_param(const char *name, const void *value, size_t size)
 {
-    auto p = gs_effect_get_param_by_name(name);
-    if (!p)
-        return;
+    set_param_value(gs_effect_get_param_by_name(name), value, size);
+}
 
-    p->param->cur_value.resize(size);
-    memcpy(p->param->cur_value.data(), value, size);
-    p->param->changed = true;
+void gs_program::gs_effect_set_texture(gs_effect_param_id id, std::shared_ptr<gs_texture> tex)
+{
+    set_param_texture(gs_effect_get_param(id), tex);
+}
+
+void gs_program::gs_effect_set_param(gs_effect_param_id id, float value)
+{
+    set_param_value(gs_effect_get_param(id), &value, sizeof(float));
+}
+
+void gs_program::gs_effect_set_param(gs_effect_param_id id, const glm::vec4 &value)
+{
+    set_param_value(gs_effect_get_param(id), &value, sizeof(glm::vec4));
+}
+
+void gs_program::gs_effect_set_param(gs_effect_param_id id, const glm::vec2 &value)
+{
+    set_param_value(gs_effect_get_param(id), &value, sizeof(glm::vec2));
+}
+
+void gs_program::gs_effect_set_param(gs_effect_param_id id, const glm::mat4x4 &value)
+{
+    set_param_value(gs_effect_get_param(id), &value, sizeof(glm::mat4x4));
+}
+
+void gs_program::gs_effect_set_param(gs_effect_param_id id, const void *value, size_t size)
+{
+    set_param_value(gs_effect_get_param(id), value, size);
 }
 
-static inline bool validate_param(const program_param &pp, size_t expected_size)
+void gs_program::set_param_value(program_param *p, const void *value, size_t size)
 {
-    if (pp.param->cur_value.size() != expected_size) {
+    if (!p || !p->upload)
+        return;
+
+    if (size != p->size) {
         blog(LOG_ERROR,
              "Parameter '%s' set to invalid size %u, "
              "expected %u",
-             pp.param->name.c_str(), (unsigned int)pp.param->cur_value.size(), (unsigned int)expected_size);
-        return false;
+             p->param->name.c_str(), (unsigned int)size, (unsigned int)p->size);
+        return;
     }
 
-    return true;
+    /* uniforms keep their value in the program, setting the one it
+     * already has needs no upload */
+    uint8_t *dst = d_ptr->values.data() + p->offset;
+    if (!p->dirty && memcmp(dst, value, size) == 0)
+        return;
+
+    memcpy(dst, value, size);
+    p->dirty = true;
+}
+
+void gs_program::set_param_texture(program_param *p, std::shared_ptr<gs_texture> tex)
+{
+    if (!p || p->param->type != gs_shader_param_type::GS_SHADER_PARAM_TEXTURE)
+        return;
+
+    p->param->texture = tex;
+    p->param->changed = true;
+}
+
+static void upload_int(GLint obj, const void *data)
+{
+    glUniform1iv(obj, 1, (const GLint *)data);
+    gl_success("glUniform1iv");
+}
+
+static void upload_int2(GLint obj, const void *data)
+{
+    glUniform2iv(obj, 1, (const GLint *)data);
+    gl_success("glUniform2iv");
+}
+
+static void upload_int3(GLint obj, const void *data)
+{
+    glUniform3iv(obj, 1, (const GLint *)data);
+    gl_success("glUniform3iv");
+}
+
+static void upload_int4(GLint obj, const void *data)
+{
+    glUniform4iv(obj, 1, (const GLint *)data);
+    gl_success("glUniform4iv");
+}
+
+static void upload_float(GLint obj, const void *data)
+{
+    glUniform1fv(obj, 1, (const GLfloat *)data);
+    gl_success("glUniform1fv");
+}
+
+static void upload_vec2(GLint obj, const void *data)
+{
+    glUniform2fv(obj, 1, (const GLfloat *)data);
+    gl_success("glUniform2fv");
+}
+
+static void upload_vec3(GLint obj, const void *data)
+{
+    glUniform3fv(obj, 1, (const GLfloat *)data);
+    gl_success("glUniform3fv");
+}
+
+static void upload_vec4(GLint obj, const void *data)
+{
+    glUniform4fv(obj, 1, (const GLfloat *)data);
+    gl_success("glUniform4fv");
+}
+
+static void upload_matrix4(GLint obj, const void *data)
+{
+    glUniformMatrix4fv(obj, 1, false, (const GLfloat *)data);
+    gl_success("glUniformMatrix4fv");
+}
+
+static param_upload_t get_param_upload(gs_shader_param_type type, size_t *size)
+{
+    switch (type) {
+    case gs_shader_param_type::GS_SHADER_PARAM_BOOL:
+    case gs_shader_param_type::GS_SHADER_PARAM_INT:
+        *size = sizeof(int);
+        return upload_int;
+    case gs_shader_param_type::GS_SHADER_PARAM_INT2:
+        *size = sizeof(int) * 2;
+        return upload_int2;
+    case gs_shader_param_type::GS_SHADER_PARAM_INT3:
+        *size = sizeof(int) * 3;
+        return upload_int3;
+    case gs_shader_param_type::GS_SHADER_PARAM_INT4:
+        *size = sizeof(int) * 4;
+        return upload_int4;
+    case gs_shader_param_type::GS_SHADER_PARAM_FLOAT:
+        *size = sizeof(float);
+        return upload_float;
+    case gs_shader_param_type::GS_SHADER_PARAM_VEC2:
+        *size = sizeof(glm::vec2);
+        return upload_vec2;
+    case gs_shader_param_type::GS_SHADER_PARAM_VEC3:
+        *size = sizeof(float) * 3;
+        return upload_vec3;
+    case gs_shader_param_type::GS_SHADER_PARAM_VEC4:
+        *size = sizeof(glm::vec4);
+        return upload_vec4;
+    case gs_shader_param_type::GS_SHADER_PARAM_MATRIX4X4:
+        *size = sizeof(glm::mat4x4);
+        return upload_matrix4;
+    default:
+        *size = 0;
+        return nullptr;
+    }
 }
 
 void gs_program::gs_effect_upload_parameters(bool change_only)
 {
-    for (int i = 0; i < d_ptr->params.size(); ++i) {
-        auto &param = d_ptr->params[i];
-        if (change_only && !param.param->changed)
-            continue;
-        if (param.param->cur_value.empty() && !param.param->texture.lock()) {
-            param.param->changed = false;
+    for (auto &p : d_ptr->params) {
+        if (p.upload) {
+            if (p.dirty) {
+                p.upload(p.obj, d_ptr->values.data() + p.offset);
+                p.dirty = false;
+            }
             continue;
         }
 
-        void *array = param.param->cur_value.data();
+        if (p.param->type != gs_shader_param_type::GS_SHADER_PARAM_TEXTURE)
+            continue;
+        if (change_only && !p.param->changed)
+            continue;
 
-        if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_BOOL ||
-                param.param->type == gs_shader_param_type::GS_SHADER_PARAM_INT) {
-            if (validate_param(param, sizeof(int))) {
-                glUniform1iv(param.obj, 1, (int *)array);
-                gl_success("glUniform1iv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_INT2) {
-            if (validate_param(param, sizeof(int) * 2)) {
-                glUniform2iv(param.obj, 1, (int *)array);
-                gl_success("glUniform2iv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_INT3) {
-            if (validate_param(param, sizeof(int) * 3)) {
-                glUniform3iv(param.obj, 1, (int *)array);
-                gl_success("glUniform3iv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_INT4) {
-            if (validate_param(param, sizeof(int) * 4)) {
-                glUniform4iv(param.obj, 1, (int *)array);
-                gl_success("glUniform4iv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_FLOAT) {
-            if (validate_param(param, sizeof(float))) {
-                glUniform1fv(param.obj, 1, (float *)array);
-                gl_success("glUniform1fv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_VEC2) {
-            if (validate_param(param, sizeof(glm::vec2))) {
-                glUniform2fv(param.obj, 1, (float *)array);
-                gl_success("glUniform2fv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_VEC3) {
-            if (validate_param(param, sizeof(float) * 3)) {
-                glUniform3fv(param.obj, 1, (float *)array);
-                gl_success("glUniform3fv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_VEC4) {
-            if (validate_param(param, sizeof(glm::vec4))) {
-                glUniform4fv(param.obj, 1, (float *)array);
-                gl_success("glUniform4fv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_MATRIX4X4) {
-            if (validate_param(param, sizeof(glm::mat4x4))) {
-                glUniformMatrix4fv(param.obj, 1, false, (float *)array);
-                gl_success("glUniformMatrix4fv");
-            }
-        } else if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_TEXTURE) {
-            glUniform1i(param.obj, param.param->texture_id);
-            gs_load_texture(param.param->texture, param.param->texture_id);
-        }
+        p.param->changed = false;
+        if (p.param->texture.expired())
+            continue;
 
-        param.param->changed = false;
+        /* the sampler's unit never changes, it is set on first use */
+        if (p.dirty) {
+            glUniform1i(p.obj, p.param->texture_id);
+            gl_success("glUniform1i");
+            p.dirty = false;
+        }
+        gs_load_texture(p.param->texture, p.param->texture_id);
     }
 }
 
 void gs_program::gs_effect_clear_tex_params()
 {
-    for (int i = 0; i < d_ptr->params.size(); ++i) {
-        auto &param = d_ptr->params[i];
-        if (param.param->type == gs_shader_param_type::GS_SHADER_PARAM_TEXTURE) {
-            param.param->texture.reset();
-        }
+    for (auto &p : d_ptr->params) {
+        if (p.param->type == gs_shader_param_type::GS_SHADER_PARAM_TEXTURE)
+            p.param->texture.reset();
     }
 }
 
 void gs_program::gs_effect_clear_all_params()
 {
-    for (int i = 0; i < d_ptr->params.size(); ++i) {
-        auto &param = d_ptr->params[i];
-        param.param->cur_value.clear();
-        param.param->changed = false;
-    }
+    for (auto &p : d_ptr->params)
+        p.param->changed = false;
 }
 
 std::shared_ptr<gs_shader> gs_program::gs_effect_vertex_shader()
@@ -343,6 +452,18 @@ bool gs_program::assign_program_param(const std::shared_ptr<gs_shader_param> &pa
     }
 
     info.param = param;
+    info.upload = get_param_upload(param->type, &info.size);
+    info.offset = d_ptr->values.size();
+    d_ptr->values.resize(info.offset + info.size);
+
+    /* gl starts uniforms at zero, only a default needs uploading */
+    if (info.upload && param->def_value.size() == info.size) {
+        memcpy(d_ptr->values.data() + info.offset, param->def_value.data(), info.size);
+        info.dirty = true;
+    } else if (!info.upload) {
+        info.dirty = true;
+    }
+
     d_ptr->params.push_back(std::move(info));
     return true;
 }
@@ -366,9 +487,25 @@ bool gs_program::assign_program_params()
     if (!assign_program_shader_params(d_ptr->pixel_shader))
         return false;
 
+    for (size_t i = 0; i < (size_t)gs_effect_param_id::GS_PARAM_COUNT; i++) {
+        d_ptr->known_params[i] = -1;
+        for (size_t j = 0; j < d_ptr->params.size(); j++) {
+            if (d_ptr->params[j].param->name == effect_param_names[i]) {
+                d_ptr->known_params[i] = (int)j;
+                break;
+            }
+        }
+    }
+
     return true;
 }
 
+program_param *gs_program::gs_effect_get_param(gs_effect_param_id id)
+{
+    int index = d_ptr->known_params[(size_t)id];
+    return index < 0 ? nullptr : &d_ptr->params[index];
+}
+
 program_param *gs_program::gs_effect_get_param_by_name(const char *name)
 {
     for (int i = 0; i < d_ptr->params.size(); ++i) {
@@ -4,9 +4,39 @@
 #include <vector>
 #include <glm/vec4.hpp>
 #include <glm/vec2.hpp>
+#include <glm/mat4x4.hpp>
 #include "gs_subsystem_info.h"
 #include "gs_shader_info.h"
 
+/* parameters set while rendering frames, their locations are resolved once
+ * when the program is created so setting them needs no name lookup */
+enum class gs_effect_param_id {
+    GS_PARAM_VIEWPROJ,
+    GS_PARAM_IMAGE,
+    GS_PARAM_IMAGE0,
+    GS_PARAM_IMAGE1,
+    GS_PARAM_IMAGE2,
+    GS_PARAM_IMAGE3,
+    GS_PARAM_IMAGE4,
+    GS_PARAM_IMAGE5,
+    GS_PARAM_IMAGE6,
+    GS_PARAM_IMAGE7,
+    GS_PARAM_WIDTH,
+    GS_PARAM_HEIGHT,
+    GS_PARAM_WIDTH_D2,
+    GS_PARAM_HEIGHT_D2,
+    GS_PARAM_WIDTH_I,
+    GS_PARAM_COLOR_VEC0,
+    GS_PARAM_COLOR_VEC1,
+    GS_PARAM_COLOR_VEC2,
+    GS_PARAM_COLOR_RANGE_MIN,
+    GS_PARAM_COLOR_RANGE_MAX,
+    GS_PARAM_BASE_DIMENSION,
+    GS_PARAM_BASE_DIMENSION_F,
+    GS_PARAM_BASE_DIMENSION_I,
+    GS_PARAM_COUNT,
+};
+
 struct program_param;
 struct gs_program_private;
 class gs_texture;
@@ -27,6 +57,13 @@ public:
     void gs_effect_set_param(const char *name, const glm::vec2 &value);
     void gs_effect_set_param(const char *name, const void *value, size_t size);
 
+    void gs_effect_set_texture(gs_effect_param_id id, std::shared_ptr<gs_texture> tex);
+    void gs_effect_set_param(gs_effect_param_id id, float value);
+    void gs_effect_set_param(gs_effect_param_id id, const glm::vec4 &value);
+    void gs_effect_set_param(gs_effect_param_id id, const glm::vec2 &value);
+    void gs_effect_set_param(gs_effect_param_id id, const glm::mat4x4 &value);
+    void gs_effect_set_param(gs_effect_param_id id, const void *value, size_t size);
+
     void gs_effect_upload_parameters(bool change_only);
     void gs_effect_clear_tex_params();
     void gs_effect_clear_all_params();
@@ -46,6 +83,9 @@ private:
     bool assign_program_params();
 
     program_param* gs_effect_get_param_by_name(const char *name);
+    program_param* gs_effect_get_param(gs_effect_param_id id);
+    void set_param_value(program_param *p, const void *value, size_t size);
+    void set_param_texture(program_param *p, std::shared_ptr<gs_texture> tex);
 
 private:
     std::unique_ptr<gs_program_private> d_ptr{};
@@ -14,9 +14,6 @@ struct gs_shader_private
     gs_shader_type type{};
     GLuint obj{};
 
-    std::shared_ptr<gs_shader_param> viewproj{};
-    std::shared_ptr<gs_shader_param> world{};
-
     std::vector<shader_attrib> attribs{};
     std::vector<std::shared_ptr<gs_shader_param>> params{};
 
@@ -65,9 +62,16 @@ bool gs_shader::gs_shader_init(const gs_shader_info &info)
         return false;
 
 #if defined WIN32
-    std::string shader_str = "#version 150\n" + info.shader;
+    /* 330 for explicit fragment output locations of the mrt conversion */
+    std::string shader_str = "#version 330\n" + info.shader;
 #else
-    std::string shader_str = "#version 300 es\n" + info.shader;
+    /* es fragment shaders have no default float precision, strict drivers
+     * (mesa) refuse to compile without one; ints default to mediump there,
+     * too narrow for the linear plane offsets of the packed conversion */
+    std::string shader_str = "#version 300 es\n";
+    if (info.type == gs_shader_type::GS_SHADER_PIXEL)
+        shader_str += "precision highp float;\nprecision highp int;\n";
+    shader_str += info.shader;
 #endif
     auto str = shader_str.data();
     glShaderSource(d_ptr->obj, 1, (const GLchar **)&str,
@@ -158,21 +162,6 @@ const std::vector<std::shared_ptr<gs_sampler_state> > &gs_shader::gs_shader_samp
     return d_ptr->samplers;
 }
 
-void gs_shader::gs_shader_set_matrix4(const glm::mat4x4 &val)
-{
-    gs_shader_set_matrix4(d_ptr->viewproj, val);
-}
-
-void gs_shader::gs_shader_set_matrix4(const std::shared_ptr<gs_shader_param> &param, const glm::mat4x4 &val)
-{
-    if (!param)
-        return;
-
-    param->cur_value.resize(sizeof(glm::mat4x4));
-    memcpy(param->cur_value.data(), &val, sizeof(glm::mat4x4));
-    param->changed = true;
-}
-
 std::string gs_shader::gl_get_shader_info(GLuint shader)
 {
     std::string errors;
@@ -196,21 +185,15 @@ bool gs_shader::gl_add_param(const gl_parser_shader_var &var, GLint *texture_id)
 {
     auto param = std::make_shared<gs_shader_param>();
 
-    param->def_value.resize(var.default_val.size());
-    param->cur_value.resize(var.default_val.size());
-
     param->name = var.name;
     param->type = get_shader_param_type(var.type.c_str());
 
     if (param->type == gs_shader_param_type::GS_SHADER_PARAM_TEXTURE) {
         param->sampler_id = var.gl_sampler_id;
         param->texture_id = (*texture_id)++;
-    } else {
-        param->changed = true;
     }
 
     param->def_value = var.default_val;
-    param->cur_value = param->def_value;
 
     d_ptr->params.push_back(std::move(param));
     return true;
@@ -224,9 +207,6 @@ bool gs_shader::gl_add_params(const std::vector<gl_parser_shader_var> &vars)
         if (!gl_add_param(vars[i], &tex_id))
             return false;
 
-    d_ptr->viewproj = gs_shader_get_param_by_name("ViewProj");
-    d_ptr->world = gs_shader_get_param_by_name("World");
-
     return true;
 }
 
@@ -32,9 +32,6 @@ public:
     std::shared_ptr<gs_shader_param> gs_shader_param_by_unit(int unit);
     const std::vector<std::shared_ptr<gs_sampler_state>> &gs_shader_samplers() const;
 
-    void gs_shader_set_matrix4(const glm::mat4x4 &val);
-    void gs_shader_set_matrix4(const std::shared_ptr<gs_shader_param> &param, const glm::mat4x4 &val);
-
 private:
     std::string gl_get_shader_info(GLuint shader);
     bool gl_add_param(const gl_parser_shader_var &var, GLint *texture_id);
@@ -62,7 +62,6 @@ struct gs_shader_param {
 
     std::weak_ptr<gs_texture> texture;
 
-    std::vector<uint8_t> cur_value{};
     std::vector<uint8_t> def_value{};
     bool changed{};
 
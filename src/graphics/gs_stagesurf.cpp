@@ -15,8 +15,11 @@ struct gs_stagesurface_private
     GLint gl_internal_format{};
     GLenum gl_type{};
     GLuint pack_buffer{};
+    GLsync fence{};
 
     ~gs_stagesurface_private() {
+        if (fence)
+            glDeleteSync(fence);
         if (pack_buffer)
             gl_delete_buffers(1, &pack_buffer);
     }
@@ -76,6 +79,16 @@ bool gs_stagesurface::gs_stagesurface_create(uint32_t width, uint32_t height, gs
     return true;
 }
 
+void gs_stagesurface::insert_fence()
+{
+    if (d_ptr->fence)
+        glDeleteSync(d_ptr->fence);
+
+    d_ptr->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (!gl_success("glFenceSync"))
+        d_ptr->fence = 0;
+}
+
 bool gs_stagesurface::can_stage(std::shared_ptr<gs_texture> src)
 {
     if (!src) {
@@ -96,7 +109,7 @@ bool gs_stagesurface::can_stage(std::shared_ptr<gs_texture> src)
 
     return true;
 }
-#ifdef __ANDROID__
+#if defined __ANDROID__ || defined __linux__
 
 /* Apparently for mac, PBOs won't do an asynchronous transfer unless you use
  * FBOs along with glReadPixels, which is really dumb. */
@@ -127,6 +140,7 @@ void gs_stagesurface::gs_stagesurface_stage_texture(std::shared_ptr<gs_texture>
     if (!gl_success("glReadPixels"))
         goto failed_unbind_all;
 
+    insert_fence();
     success = true;
 
 failed_unbind_all:
@@ -155,6 +169,8 @@ void gs_stagesurface::gs_stagesurface_stage_texture(std::shared_ptr<gs_texture>
     if (!gl_success("glGetTexImage"))
         goto failed;
 
+    insert_fence();
+
     gl_bind_texture(GL_TEXTURE_2D, 0);
     gl_bind_buffer(GL_PIXEL_PACK_BUFFER, 0);
     return;
@@ -181,12 +197,27 @@ gs_color_format gs_stagesurface::gs_stagesurface_get_color_format()
     return d_ptr->format;
 }
 
+bool gs_stagesurface::gs_stagesurface_ready()
+{
+    if (!d_ptr->fence)
+        return true;
+
+    GLenum result = glClientWaitSync(d_ptr->fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED)
+        return false;
+
+    /* signaled, or the fence failed and mapping will simply block */
+    glDeleteSync(d_ptr->fence);
+    d_ptr->fence = 0;
+    return true;
+}
+
 bool gs_stagesurface::gs_stagesurface_map(uint8_t **data, uint32_t *linesize)
 {
     if (!gl_bind_buffer(GL_PIXEL_PACK_BUFFER, d_ptr->pack_buffer))
         goto fail;
 
-#if defined __ANDROID__
+#if defined __ANDROID__ || defined __linux__
     *data = (uint8_t *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, d_ptr->size, GL_MAP_READ_BIT);
 #elif defined WIN32
     *data = (uint8_t *)glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
@@ -18,11 +18,16 @@ public:
     uint32_t gs_stagesurface_get_width();
     uint32_t gs_stagesurface_get_height();
     gs_color_format gs_stagesurface_get_color_format();
+
+    /* true once the gpu has finished the last staged copy, mapping before
+     * that stalls until it completes */
+    bool gs_stagesurface_ready();
     bool gs_stagesurface_map(uint8_t **data, uint32_t *linesize);
     void gs_stagesurface_unmap();
 
 private:
     bool create_pixel_pack_buffer();
+    void insert_fence();
     bool can_stage(std::shared_ptr<gs_texture> src);
 
 private:
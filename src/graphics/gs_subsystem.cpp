@@ -10,8 +10,10 @@
 #include "util/log.h"
 
 #include <list>
+#include <atomic>
 #include <map>
 #include <algorithm>
+#include <thread>
 #include <glm/mat4x4.hpp>
 
 std::vector<std::string> split (const std::string &s, std::string delimiter) {
@@ -37,6 +39,16 @@ struct blend_state {
     gs_blend_type dest_a{};
 };
 
+struct sprite_batch_item {
+    std::shared_ptr<gs_texture> texture{};
+    glm::mat4x4 transform{1.0f};
+    uint32_t flip{};
+    float cx{};
+    float cy{};
+};
+
+#define SPRITE_BATCH_MIN_SIZE 64
+
 struct graphics_subsystem_private
 {
     std::shared_ptr<gs_device> device{};
@@ -50,6 +62,10 @@ struct graphics_subsystem_private
 
     std::shared_ptr<gs_vertexbuffer> sprite_buffer{};
 
+    std::shared_ptr<gs_vertexbuffer> batch_buffer{};
+    size_t batch_size{};
+    std::vector<sprite_batch_item> batch_sprites{};
+
     std::mutex effect_mutex;
     std::map<std::string, std::shared_ptr<gs_program>> effects{};
 
@@ -59,9 +75,15 @@ struct graphics_subsystem_private
     std::recursive_mutex mutex;
     std::atomic_long ref{};
 
+    /* threads blocked in gs_enter_contex, and how often the context was
+     * made current on some thread */
+    std::atomic_long waiters{};
+    std::atomic<uint64_t> context_switches{};
+
     ~graphics_subsystem_private() {
         device->device_enter_context();
         sprite_buffer.reset();
+        batch_buffer.reset();
         effects.clear();
         device->device_destroy();
         device->device_leave_context();
@@ -143,8 +165,9 @@ bool graphics_subsystem::init_effect()
 
 std::shared_ptr<gs_program> graphics_subsystem::gs_get_effect_by_name(const char *name)
 {
-    if (d_ptr->effects.contains(name))
-        return d_ptr->effects.at(name);
+    auto it = d_ptr->effects.find(name);
+    if (it != d_ptr->effects.end())
+        return it->second;
 
     return nullptr;
 }
@@ -170,6 +193,102 @@ void graphics_subsystem::gs_draw_sprite(std::shared_ptr<gs_texture> tex, uint32_
     d_ptr->device->gs_device_draw(gs_draw_mode::GS_TRISTRIP, 0, 0);
 }
 
+void graphics_subsystem::gs_sprite_batch_begin()
+{
+    d_ptr->batch_sprites.clear();
+}
+
+void graphics_subsystem::gs_sprite_batch_add(std::shared_ptr<gs_texture> tex, const glm::mat4x4 &transform,
+                                             uint32_t flip, uint32_t width, uint32_t height)
+{
+    if (!tex)
+        return;
+
+    sprite_batch_item item;
+    item.cx = width ? (float)width : (float)tex->gs_texture_get_width();
+    item.cy = height ? (float)height : (float)tex->gs_texture_get_height();
+    item.texture = std::move(tex);
+    item.transform = transform;
+    item.flip = flip;
+    d_ptr->batch_sprites.push_back(std::move(item));
+}
+
+void graphics_subsystem::gs_sprite_batch_end()
+{
+    auto &sprites = d_ptr->batch_sprites;
+    if (sprites.empty())
+        return;
+
+    if (d_ptr->batch_size < sprites.size()) {
+        size_t size = std::max(sprites.size(), std::max(d_ptr->batch_size * 2, (size_t)SPRITE_BATCH_MIN_SIZE));
+        auto vb = std::make_shared<gs_vertexbuffer>();
+        if (!vb->gs_vertexbuffer_init_sprite_batch(size)) {
+            blog(LOG_ERROR, "failed to create sprite batch buffer");
+            sprites.clear();
+            return;
+        }
+
+        d_ptr->batch_buffer = std::move(vb);
+        d_ptr->batch_size = size;
+    }
+
+    auto program = gs_get_effect_by_name("Default_Draw_Batch");
+    if (!program) {
+        sprites.clear();
+        return;
+    }
+
+    /* split the sprites into runs that sample at most GS_SPRITE_BATCH_TEXTURES
+     * textures, each run keeps its place in the draw order */
+    struct sprite_run {
+        size_t start;
+        size_t count;
+        std::shared_ptr<gs_texture> textures[GS_SPRITE_BATCH_TEXTURES];
+        int num_textures;
+    };
+    std::vector<sprite_run> runs;
+
+    auto data = d_ptr->batch_buffer->gs_vertexbuffer_get_data();
+    sprite_run run{};
+    for (size_t i = 0; i < sprites.size(); i++) {
+        auto &sprite = sprites[i];
+        int slot = 0;
+        while (slot < run.num_textures && run.textures[slot] != sprite.texture)
+            slot++;
+
+        if (slot == GS_SPRITE_BATCH_TEXTURES) {
+            runs.push_back(std::move(run));
+            run = sprite_run{};
+            run.start = i;
+            slot = 0;
+        }
+
+        if (slot == run.num_textures)
+            run.textures[run.num_textures++] = sprite.texture;
+
+        data->build_batch_sprite(i, sprite.transform, sprite.cx, sprite.cy, sprite.flip, (float)slot);
+        run.count++;
+    }
+    runs.push_back(std::move(run));
+
+    d_ptr->batch_buffer->gs_vertexbuffer_flush_count(sprites.size() * 6);
+
+    d_ptr->device->gs_device_load_vertexbuffer(d_ptr->batch_buffer);
+    d_ptr->device->gs_device_load_indexbuffer(nullptr);
+
+    gs_set_cur_effect(program);
+    gs_technique_begin();
+    for (auto &r : runs) {
+        for (int i = 0; i < r.num_textures; i++)
+            program->gs_effect_set_texture((gs_effect_param_id)((int)gs_effect_param_id::GS_PARAM_IMAGE0 + i), r.textures[i]);
+
+        gs_draw(gs_draw_mode::GS_TRIS, (uint32_t)(r.start * 6), (uint32_t)(r.count * 6));
+    }
+    gs_technique_end();
+
+    sprites.clear();
+}
+
 bool graphics_subsystem::graphics_init()
 {
     bool res = false;
@@ -311,14 +430,59 @@ void gs_enter_contex(std::unique_ptr<graphics_subsystem> &graphics)
     }
 
     if (!is_current) {
+        graphics->d_ptr->waiters++;
         graphics->d_ptr->mutex.lock();
+        graphics->d_ptr->waiters--;
         graphics->d_ptr->device->device_enter_context();
+        graphics->d_ptr->context_switches++;
         thread_graphics = graphics.get();
     }
 
     graphics->d_ptr->ref++;
 }
 
+void gs_yield_context()
+{
+    if (!gs_valid("gs_yield_context"))
+        return;
+
+    graphics_subsystem *graphics = thread_graphics;
+    if (!graphics->d_ptr->waiters)
+        return;
+
+    /* let every thread already waiting take its turn before this one gets
+     * the context back, the mutex alone would not be fair to them.  The
+     * entry count belongs to whoever holds the context, so it is put aside
+     * meanwhile */
+    long ref = graphics->d_ptr->ref.exchange(0);
+    graphics->d_ptr->device->device_leave_context();
+    graphics->d_ptr->mutex.unlock();
+
+    while (graphics->d_ptr->waiters)
+        std::this_thread::yield();
+
+    graphics->d_ptr->mutex.lock();
+    graphics->d_ptr->device->device_enter_context();
+    graphics->d_ptr->context_switches++;
+    graphics->d_ptr->ref = ref;
+}
+
+uint64_t gs_context_switches()
+{
+    if (!gs_valid("gs_context_switches"))
+        return 0;
+
+    return thread_graphics->d_ptr->context_switches;
+}
+
+uint64_t gs_gl_calls()
+{
+    if (!gs_valid("gs_gl_calls"))
+        return 0;
+
+    return gl_call_count;
+}
+
 void gs_leave_context()
 {
     if (gs_valid("gs_leave_context")) {
@@ -346,6 +510,15 @@ void gs_set_render_target(std::shared_ptr<gs_texture> tex, std::shared_ptr<gs_zs
         blog(LOG_ERROR, "device_set_render_target (GL) failed");
 }
 
+void gs_set_render_targets(const std::shared_ptr<gs_texture> *textures, uint32_t count, std::shared_ptr<gs_zstencil_buffer> zs)
+{
+    if (!gs_valid("gs_set_render_targets"))
+        return;
+
+    if (!thread_graphics->d_ptr->device->gs_device_set_render_targets(textures, count, zs))
+        blog(LOG_ERROR, "device_set_render_targets (GL) failed");
+}
+
 void gs_begin_scene()
 {
     if (!gs_valid("gs_begin_scene"))
@@ -364,10 +537,7 @@ void gs_enable_depth_test(bool enable)
     if (!gs_valid("gs_enable_depth_test"))
         return;
 
-    if (enable)
-        gl_enable(GL_DEPTH_TEST);
-    else
-        gl_disable(GL_DEPTH_TEST);
+    thread_graphics->d_ptr->device->device_enable_depth_test(enable);
 }
 
 void gs_enable_blending(bool enable)
@@ -376,11 +546,7 @@ void gs_enable_blending(bool enable)
         return;
 
     thread_graphics->d_ptr->cur_blend_state.enabled = enable;
-
-    if (enable)
-        gl_enable(GL_BLEND);
-    else
-        gl_disable(GL_BLEND);
+    thread_graphics->d_ptr->device->device_enable_blending(enable);
 }
 
 void gs_set_cull_mode(gs_cull_mode mode)
@@ -415,6 +581,14 @@ void gs_get_viewport(gs_rect &rect)
     thread_graphics->d_ptr->device->gs_device_get_viewport(rect);
 }
 
+void gs_set_scissor_rect(const gs_rect *rect)
+{
+    if (!gs_valid("gs_set_scissor_rect"))
+        return;
+
+    thread_graphics->d_ptr->device->gs_device_set_scissor_rect(rect);
+}
+
 void gs_clear(uint32_t clear_flags, glm::vec4 *color, float depth, uint8_t stencil)
 {
     if (!gs_valid("gs_clear"))
@@ -428,7 +602,7 @@ void gs_clear(uint32_t clear_flags, glm::vec4 *color, float depth, uint8_t stenc
     }
 
     if (clear_flags & GS_CLEAR_DEPTH) {
-#if defined __ANDROID__
+#if defined __ANDROID__ || defined __linux__
         glClearDepthf(depth);
 #else
         glClearDepth(depth);
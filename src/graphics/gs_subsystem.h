@@ -25,6 +25,14 @@ public:
     std::shared_ptr<gs_program> gs_get_effect_by_name(const char *name);
     void gs_draw_sprite(std::shared_ptr<gs_texture> tex, uint32_t flip, uint32_t width, uint32_t height);
 
+    /* sprites added between begin and end are drawn in order with the
+     * Default_Draw_Batch effect: one vertex upload for the whole batch and
+     * one draw per GS_SPRITE_BATCH_TEXTURES distinct textures */
+    void gs_sprite_batch_begin();
+    void gs_sprite_batch_add(std::shared_ptr<gs_texture> tex, const glm::mat4x4 &transform,
+                             uint32_t flip, uint32_t width, uint32_t height);
+    void gs_sprite_batch_end();
+
 private:
     bool init_sprite_vb();
     bool init_effect();
@@ -41,6 +49,12 @@ std::unique_ptr<graphics_subsystem> gs_create_graphics_system();
 
 void gs_enter_contex(std::unique_ptr<graphics_subsystem> &graphics);
 void gs_leave_context();
+/* for a thread that keeps the context entered for long, hands it to any
+ * threads waiting in gs_enter_contex and takes it back after them */
+void gs_yield_context();
+uint64_t gs_context_switches();
+/* GL calls issued so far by any thread */
+uint64_t gs_gl_calls();
 
 void gs_begin_scene();
 void gs_end_scene();
@@ -50,10 +64,12 @@ void gs_set_cull_mode(gs_cull_mode mode);
 void gs_ortho(float left, float right, float top, float bottom, float znear, float zfar);
 void gs_set_viewport(int x, int y, int width, int height);
 void gs_get_viewport(gs_rect &rect);
+void gs_set_scissor_rect(const gs_rect *rect);
 void gs_clear(uint32_t clear_flags, glm::vec4 *color, float depth, uint8_t stencil);
 void gs_flush();
 void gs_set_render_size(uint32_t width, uint32_t height);
 void gs_set_render_target(std::shared_ptr<gs_texture> tex, std::shared_ptr<gs_zstencil_buffer> zs);
+void gs_set_render_targets(const std::shared_ptr<gs_texture> *textures, uint32_t count, std::shared_ptr<gs_zstencil_buffer> zs);
 void gs_set_cur_effect(std::shared_ptr<gs_program> program);
 void gs_load_texture(std::weak_ptr<gs_texture> tex, int unit);
 
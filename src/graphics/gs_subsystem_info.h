@@ -3,6 +3,10 @@
 #if defined __ANDROID__
 #include <GLES3/gl3.h>
 #include <EGL/egl.h>
+#elif defined __linux__
+#include <GLES3/gl3.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #elif defined WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -27,7 +31,11 @@
 #define GS_FLIP_U (1 << 0)
 #define GS_FLIP_V (1 << 1)
 
+/* texture units sampled by one draw of a sprite batch */
+#define GS_SPRITE_BATCH_TEXTURES 8
+
 #define GS_MAX_TEXTURES 8
+#define GS_MAX_RENDER_TARGETS 4
 
 enum class gs_blend_type {
     GS_BLEND_ZERO,
@@ -2,6 +2,14 @@
 #include "gs_subsystem.h"
 #include "gs_shader.h"
 
+/* uploads to a dynamic texture rotate through this many regions of its
+ * unpack buffer, a region is only written again once the fence of the copy
+ * out of it has signaled */
+#define GS_UPLOAD_SLOTS 3
+
+/* a fence still pending after this long is given up on */
+#define GS_UPLOAD_WAIT_NS 1000000000ULL
+
 static inline bool gs_is_compressed_format(gs_color_format format)
 {
     return false;
@@ -20,14 +28,48 @@ static inline uint32_t gs_get_total_levels(uint32_t width, uint32_t height)
     return num_levels;
 }
 
-bool fbo_info::attach_rendertarget(std::shared_ptr<gs_texture> tex) {
-    if (cur_render_target.lock() == tex)
-        return true;
+bool fbo_info::attach_rendertargets(const std::shared_ptr<gs_texture> *textures, uint32_t count) {
+    static const GLenum draw_buffers[GS_MAX_RENDER_TARGETS] = {
+        GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1,
+        GL_COLOR_ATTACHMENT2, GL_COLOR_ATTACHMENT3,
+    };
+
+    if (count > GS_MAX_RENDER_TARGETS)
+        return false;
+
+    for (uint32_t i = 0; i < count; i++) {
+        if (cur_render_targets[i].lock() == textures[i])
+            continue;
 
-    cur_render_target = tex;
+        cur_render_targets[i] = textures[i];
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, textures[i]->gs_texture_obj(), 0);
+        if (!gl_success("glFramebufferTexture2D"))
+            return false;
+    }
+
+    /* detach targets left over from a previous multiple target draw */
+    for (uint32_t i = count; i < num_render_targets; i++) {
+        cur_render_targets[i].reset();
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0 + i, GL_TEXTURE_2D, 0, 0);
+        if (!gl_success("glFramebufferTexture2D"))
+            return false;
+    }
 
-    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, tex->gs_texture_obj(), 0);
-    return gl_success("glFramebufferTexture2D");
+    if (count != num_render_targets) {
+        num_render_targets = count;
+        glDrawBuffers(count, draw_buffers);
+        if (!gl_success("glDrawBuffers"))
+            return false;
+    }
+
+    return true;
+}
+
+void fbo_info::reset_attachments()
+{
+    for (int i = 0; i < GS_MAX_RENDER_TARGETS; i++)
+        cur_render_targets[i].reset();
+    cur_zstencil_buffer.reset();
 }
 
 bool fbo_info::attach_zstencil(std::shared_ptr<gs_zstencil_buffer> zs)
@@ -82,7 +124,10 @@ struct gs_texture_private
     uint32_t height{};
     bool gen_mipmaps{};
     GLuint unpack_buffer{};
-    GLsizeiptr size{};
+    GLsizeiptr size{}; /* of one upload slot */
+    uint32_t upload_slot{};
+    uint8_t *upload_ptr{}; /* persistent mapping of every slot, or NULL */
+    GLsync upload_fences[GS_UPLOAD_SLOTS]{};
 };
 
 gs_texture::gs_texture()
@@ -92,6 +137,11 @@ gs_texture::gs_texture()
 
 gs_texture::~gs_texture()
 {
+    for (size_t i = 0; i < GS_UPLOAD_SLOTS; i++) {
+        if (d_ptr->upload_fences[i])
+            glDeleteSync(d_ptr->upload_fences[i]);
+    }
+
     if (!d_ptr->base.is_dummy && d_ptr->base.is_dynamic && d_ptr->unpack_buffer)
         gl_delete_buffers(1, &d_ptr->unpack_buffer);
 
@@ -195,52 +245,88 @@ void gs_texture::gs_texture_set_image(const uint8_t *data, uint32_t linesize, bo
     gs_texture_unmap();
 }
 
+void gs_texture::wait_upload_slot(uint32_t slot)
+{
+    GLsync fence = d_ptr->upload_fences[slot];
+    if (!fence)
+        return;
+
+    /* only blocks when the gpu is a whole ring of uploads behind */
+    GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GS_UPLOAD_WAIT_NS);
+    glDeleteSync(fence);
+    d_ptr->upload_fences[slot] = 0;
+
+    if (result == GL_WAIT_FAILED || result == GL_TIMEOUT_EXPIRED)
+        blog(LOG_WARNING, "gs_texture_map: upload slot %u still busy", slot);
+}
+
 bool gs_texture::gs_texture_map(uint8_t **ptr, uint32_t *linesize)
 {
+    uint32_t slot;
+    GLintptr offset;
+
     if (!d_ptr->base.is_dynamic) {
         blog(LOG_ERROR, "Texture is not dynamic");
         goto fail;
     }
 
-    if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffer))
-        goto fail;
-
-#if defined __ANDROID__
-    *ptr = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, d_ptr->size, GL_MAP_WRITE_BIT);
-#elif defined WIN32
-    *ptr = (uint8_t *)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-#endif
-    if (!gl_success("glMapBuffer"))
-        goto fail;
+    slot = (d_ptr->upload_slot + 1) % GS_UPLOAD_SLOTS;
+    offset = (GLintptr)slot * d_ptr->size;
+    wait_upload_slot(slot);
+    d_ptr->upload_slot = slot;
 
-    gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (d_ptr->upload_ptr) {
+        *ptr = d_ptr->upload_ptr + offset;
+    } else {
+        if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffer))
+            goto fail;
+
+        /* the slot's fence already signaled, no need for the driver to
+         * synchronize with the copies out of the other slots */
+        *ptr = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, offset, d_ptr->size,
+                                           GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+                                           GL_MAP_UNSYNCHRONIZED_BIT);
+        if (!gl_success("glMapBufferRange") || !*ptr)
+            goto fail;
+
+        gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
 
     *linesize = d_ptr->width * gs_get_format_bpp(d_ptr->base.format) / 8;
     *linesize = (*linesize + 3) & 0xFFFFFFFC;
     return true;
 
 fail:
+    gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
     blog(LOG_ERROR, "gs_texture_map (GL) failed");
     return false;
 }
 
 void gs_texture::gs_texture_unmap()
 {
+    GLintptr offset = (GLintptr)d_ptr->upload_slot * d_ptr->size;
+
     if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, d_ptr->unpack_buffer))
         goto failed;
 
-    glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-    if (!gl_success("glUnmapBuffer"))
-        goto failed;
+    if (!d_ptr->upload_ptr) {
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        if (!gl_success("glUnmapBuffer"))
+            goto failed;
+    }
 
     if (!gl_bind_texture(GL_TEXTURE_2D, d_ptr->base.texture))
         goto failed;
 
-    glTexImage2D(GL_TEXTURE_2D, 0, d_ptr->base.gl_internal_format, d_ptr->width,
-                 d_ptr->height, 0, d_ptr->base.gl_format, d_ptr->base.gl_type, 0);
-    if (!gl_success("glTexImage2D"))
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, d_ptr->width, d_ptr->height,
+                    d_ptr->base.gl_format, d_ptr->base.gl_type, (const void *)offset);
+    if (!gl_success("glTexSubImage2D"))
         goto failed;
 
+    d_ptr->upload_fences[d_ptr->upload_slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (!gl_success("glFenceSync"))
+        d_ptr->upload_fences[d_ptr->upload_slot] = 0;
+
     gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
     gl_bind_texture(GL_TEXTURE_2D, 0);
     return;
@@ -282,8 +368,7 @@ std::shared_ptr<fbo_info> gs_texture::get_fbo()
     d_ptr->base.fbo->width = width;
     d_ptr->base.fbo->height = height;
     d_ptr->base.fbo->format = d_ptr->base.format;
-    d_ptr->base.fbo->cur_render_target.reset();
-    d_ptr->base.fbo->cur_zstencil_buffer.reset();
+    d_ptr->base.fbo->reset_attachments();
 
     return d_ptr->base.fbo;
 }
@@ -336,6 +421,11 @@ bool gs_texture::gs_texture_load_texture_sampler(std::shared_ptr<gs_sampler_stat
     return success;
 }
 
+bool gs_texture::gs_texture_sampler_loaded(const std::shared_ptr<gs_sampler_state> &ss)
+{
+    return d_ptr->base.cur_sampler.lock() == ss;
+}
+
 bool gs_texture::upload_texture_2d(const uint8_t **data)
 {
     uint32_t row_size = d_ptr->width * gs_get_format_bpp(d_ptr->base.format);
@@ -375,6 +465,7 @@ bool gs_texture::create_pixel_unpack_buffer()
 {
     GLsizeiptr size;
     bool success = true;
+    bool allocated = false;
 
     if (!gl_gen_buffers(1, &d_ptr->unpack_buffer))
         return false;
@@ -392,9 +483,27 @@ bool gs_texture::create_pixel_unpack_buffer()
         size /= 8;
     }
 
-    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, 0, GL_DYNAMIC_DRAW);
-    if (!gl_success("glBufferData"))
-        success = false;
+    /* mapped once for the texture's lifetime, an upload is then just the
+     * copy into the next slot */
+    if (gl_buffer_storage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT_EXT |
+                GL_MAP_COHERENT_BIT_EXT;
+
+        gl_buffer_storage(GL_PIXEL_UNPACK_BUFFER, size * GS_UPLOAD_SLOTS, 0, flags);
+        allocated = gl_success("glBufferStorageEXT");
+        if (allocated) {
+            d_ptr->upload_ptr = (uint8_t *)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0,
+                                                            size * GS_UPLOAD_SLOTS, flags);
+            if (!gl_success("glMapBufferRange"))
+                d_ptr->upload_ptr = nullptr;
+        }
+    }
+
+    if (!allocated) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, size * GS_UPLOAD_SLOTS, 0, GL_DYNAMIC_DRAW);
+        if (!gl_success("glBufferData"))
+            success = false;
+    }
 
     if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
         success = false;
@@ -70,10 +70,12 @@ struct fbo_info {
     uint32_t height{};
     gs_color_format format{};
 
-    std::weak_ptr<gs_texture> cur_render_target{};
+    std::weak_ptr<gs_texture> cur_render_targets[GS_MAX_RENDER_TARGETS]{};
+    uint32_t num_render_targets{};
     std::weak_ptr<gs_zstencil_buffer> cur_zstencil_buffer{};
 
-    bool attach_rendertarget(std::shared_ptr<gs_texture> tex);
+    bool attach_rendertargets(const std::shared_ptr<gs_texture> *textures, uint32_t count);
+    void reset_attachments();
     bool attach_zstencil(std::shared_ptr<gs_zstencil_buffer> zs);
 
     ~fbo_info();
@@ -108,9 +110,11 @@ public:
     GLenum gs_texture_target();
 
     bool gs_texture_load_texture_sampler(std::shared_ptr<gs_sampler_state> ss);
+    bool gs_texture_sampler_loaded(const std::shared_ptr<gs_sampler_state> &ss);
 
 private:
     bool create_pixel_unpack_buffer();
+    void wait_upload_slot(uint32_t slot);
     bool upload_texture_2d(const uint8_t **data);
     bool gs_set_target(int side, std::shared_ptr<gs_zstencil_buffer> zs);
     bool get_tex_dimensions(uint32_t *width, uint32_t *height);
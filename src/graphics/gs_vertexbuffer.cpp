@@ -1,10 +1,20 @@
 #include "gs_vertexbuffer.h"
 #include "gl-helpers.h"
+#include "gs_program.h"
+#include "gs_shader.h"
 #include <stdint.h>
+#include <string.h>
+
+/* attribute pointers depend on the locations the program assigned, so each
+ * program drawing from the buffer gets a vertex array of its own */
+struct vb_program_vao {
+    std::weak_ptr<gs_program> program{};
+    GLuint vao{};
+};
 
 struct gs_vertexbuffer_private
 {
-    GLuint vao{};
+    std::vector<vb_program_vao> vaos{};
     GLuint vertex_buffer{};
     GLuint normal_buffer{};
     GLuint tangent_buffer{};
@@ -28,8 +38,8 @@ struct gs_vertexbuffer_private
         if (uv_buffers.size())
             gl_delete_buffers((GLsizei)uv_buffers.size(), uv_buffers.data());
 
-        if (vao)
-            gl_delete_vertex_arrays(1, &vao);
+        for (auto &entry : vaos)
+            gl_delete_vertex_arrays(1, &entry.vao);
     }
 };
 
@@ -52,8 +62,9 @@ gs_vertexbuffer::~gs_vertexbuffer()
         gl_delete_buffers((GLsizei)d_ptr->uv_buffers.size(),
                           d_ptr->uv_buffers.data());
 
-    if (d_ptr->vao)
-        gl_delete_vertex_arrays(1, &d_ptr->vao);
+    for (auto &entry : d_ptr->vaos)
+        gl_delete_vertex_arrays(1, &entry.vao);
+    d_ptr->vaos.clear();
 
     blog(LOG_DEBUG, "gs_vertexbuffer destroyed.");
 }
@@ -109,22 +120,19 @@ bool gs_vertexbuffer::create_buffers()
         d_ptr->data.reset();
     }
     
-    if (!gl_gen_vertex_arrays(1, &d_ptr->vao))
-        return false;
-    
     return true;
 }
 
-bool gs_vertexbuffer::gs_vertexbuffer_init_sprite()
+bool gs_vertexbuffer::init_sprite_buffers(size_t num)
 {
     d_ptr->data = std::make_shared<gs_vb_data>();
-    d_ptr->data->num = 4;
-    d_ptr->data->points.resize(4);
+    d_ptr->data->num = num;
+    d_ptr->data->points.resize(num);
     d_ptr->data->num_tex = 1;
     d_ptr->data->tvarray.resize(1);
     d_ptr->data->tvarray[0].width = 2;
-    d_ptr->data->tvarray[0].array = malloc(sizeof(glm::vec2) * 4);
-    memset(d_ptr->data->tvarray[0].array, 0, sizeof(glm::vec2) * 4);
+    d_ptr->data->tvarray[0].array = malloc(sizeof(glm::vec2) * num);
+    memset(d_ptr->data->tvarray[0].array, 0, sizeof(glm::vec2) * num);
 
     d_ptr->num = d_ptr->data->num;
     d_ptr->dynamic = true;
@@ -132,6 +140,16 @@ bool gs_vertexbuffer::gs_vertexbuffer_init_sprite()
     return create_buffers();
 }
 
+bool gs_vertexbuffer::gs_vertexbuffer_init_sprite()
+{
+    return init_sprite_buffers(4);
+}
+
+bool gs_vertexbuffer::gs_vertexbuffer_init_sprite_batch(size_t num_sprites)
+{
+    return init_sprite_buffers(num_sprites * 6);
+}
+
 std::shared_ptr<gs_vb_data> gs_vertexbuffer::gs_vertexbuffer_get_data()
 {
     return d_ptr->data;
@@ -139,12 +157,17 @@ std::shared_ptr<gs_vb_data> gs_vertexbuffer::gs_vertexbuffer_get_data()
 
 void gs_vertexbuffer::gs_vertexbuffer_flush()
 {
-    gs_vertexbuffer_flush_internal(d_ptr->data.get());
+    gs_vertexbuffer_flush_internal(d_ptr->data.get(), d_ptr->num);
+}
+
+void gs_vertexbuffer::gs_vertexbuffer_flush_count(size_t num)
+{
+    gs_vertexbuffer_flush_internal(d_ptr->data.get(), num < d_ptr->num ? num : d_ptr->num);
 }
 
 void gs_vertexbuffer::gs_vertexbuffer_flush_direct(const gs_vb_data *data)
 {
-    gs_vertexbuffer_flush_internal(data);
+    gs_vertexbuffer_flush_internal(data, data->num);
 }
 
 bool gs_vertexbuffer::gs_load_vb_buffers(attrib_type t, size_t index, GLuint id)
@@ -178,9 +201,41 @@ bool gs_vertexbuffer::gs_load_vb_buffers(attrib_type t, size_t index, GLuint id)
     return success;
 }
 
-GLuint gs_vertexbuffer::gs_vertexbuffer_vao()
+GLuint gs_vertexbuffer::gs_vertexbuffer_vao(const std::shared_ptr<gs_program> &program)
 {
-    return d_ptr->vao;
+    vb_program_vao *entry = nullptr;
+    for (auto &e : d_ptr->vaos) {
+        auto p = e.program.lock();
+        if (p == program)
+            return e.vao;
+        if (!p && !entry)
+            entry = &e;
+    }
+
+    /* the slot of a destroyed program is reused, its vertex array is
+     * recreated since it has other attributes enabled */
+    if (entry) {
+        gl_delete_vertex_arrays(1, &entry->vao);
+        entry->vao = 0;
+    } else {
+        d_ptr->vaos.emplace_back();
+        entry = &d_ptr->vaos.back();
+    }
+    entry->program = program;
+
+    if (!gl_gen_vertex_arrays(1, &entry->vao))
+        return 0;
+    if (!gl_bind_vertex_array(entry->vao))
+        return 0;
+
+    auto &attribs = program->gs_effect_vertex_shader()->gs_shader_attribs();
+    auto &s_attribs = program->gs_effect_attribs();
+    for (size_t i = 0; i < attribs.size(); ++i) {
+        if (!gs_load_vb_buffers(attribs[i].type, attribs[i].index, s_attribs[i]))
+            return 0;
+    }
+
+    return entry->vao;
 }
 
 size_t gs_vertexbuffer::gs_vertexbuffer_num()
@@ -188,7 +243,7 @@ size_t gs_vertexbuffer::gs_vertexbuffer_num()
     return d_ptr->num;
 }
 
-void gs_vertexbuffer::gs_vertexbuffer_flush_internal(const gs_vb_data *data)
+void gs_vertexbuffer::gs_vertexbuffer_flush_internal(const gs_vb_data *data, size_t num)
 {
     size_t i;
     size_t num_tex = data->num_tex < d_ptr->data->num_tex ? data->num_tex
@@ -202,34 +257,34 @@ void gs_vertexbuffer::gs_vertexbuffer_flush_internal(const gs_vb_data *data)
     if (data->points.size()) {
         if (!update_buffer(GL_ARRAY_BUFFER, d_ptr->vertex_buffer,
                            data->points.data(),
-                           data->num * sizeof(glm::vec4)))
+                           num * sizeof(glm::vec4)))
             goto failed;
     }
 
     if (d_ptr->normal_buffer && data->normals.size()) {
         if (!update_buffer(GL_ARRAY_BUFFER, d_ptr->normal_buffer,
                            data->normals.data(),
-                           data->num * sizeof(glm::vec4)))
+                           num * sizeof(glm::vec4)))
             goto failed;
     }
 
     if (d_ptr->tangent_buffer && data->tangents.size()) {
         if (!update_buffer(GL_ARRAY_BUFFER, d_ptr->tangent_buffer,
                            data->tangents.data(),
-                           data->num * sizeof(glm::vec4)))
+                           num * sizeof(glm::vec4)))
             goto failed;
     }
 
     if (d_ptr->color_buffer && data->colors.size()) {
         if (!update_buffer(GL_ARRAY_BUFFER, d_ptr->color_buffer,
-                           data->colors.data(), data->num * sizeof(uint32_t)))
+                           data->colors.data(), num * sizeof(uint32_t)))
             goto failed;
     }
 
     for (i = 0; i < num_tex; i++) {
         GLuint buffer = d_ptr->uv_buffers[i];
         const gs_tvertarray &tv = data->tvarray[i];
-        size_t size = data->num * tv.width * sizeof(float);
+        size_t size = num * tv.width * sizeof(float);
 
         if (!update_buffer(GL_ARRAY_BUFFER, buffer, tv.array, size))
             goto failed;
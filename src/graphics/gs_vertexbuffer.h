@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
 #include "gs_subsystem_info.h"
 
 struct gs_tvertarray {
@@ -58,6 +59,36 @@ struct gs_vb_data {
         build_sprite(fcx, fcy, start_u, end_u, start_v, end_v);
     }
 
+    /* batched sprites are two triangles each so any run of them can be drawn
+     * with one call, the texture slot the sprite samples rides in pos.w */
+    void build_batch_sprite(size_t index, const glm::mat4x4 &transform, float fcx, float fcy,
+                            uint32_t flip, float slot) {
+        float start_u, end_u;
+        float start_v, end_v;
+
+        assign_sprite_uv(&start_u, &end_u, (flip & GS_FLIP_U) != 0);
+        assign_sprite_uv(&start_v, &end_v, (flip & GS_FLIP_V) != 0);
+
+        glm::vec4 corners[4] = {
+            transform * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+            transform * glm::vec4(fcx, 0.0f, 0.0f, 1.0f),
+            transform * glm::vec4(0.0f, fcy, 0.0f, 1.0f),
+            transform * glm::vec4(fcx, fcy, 0.0f, 1.0f),
+        };
+        glm::vec2 uvs[4] = {
+            {start_u, start_v}, {end_u, start_v},
+            {start_u, end_v}, {end_u, end_v},
+        };
+        static const int order[6] = {0, 1, 2, 2, 1, 3};
+
+        glm::vec2 *tv = (glm::vec2 *)tvarray[0].array + index * 6;
+        glm::vec4 *pt = points.data() + index * 6;
+        for (int i = 0; i < 6; i++) {
+            pt[i] = glm::vec4(corners[order[i]].x, corners[order[i]].y, 0.0f, slot);
+            tv[i] = uvs[order[i]];
+        }
+    }
+
     ~gs_vb_data() {
         for (int i = 0; i < num_tex; ++i) {
             free(tvarray[i].array);
@@ -65,6 +96,7 @@ struct gs_vb_data {
     }
 };
 
+class gs_program;
 struct gs_vertexbuffer_private;
 class gs_vertexbuffer
 {
@@ -73,21 +105,27 @@ public:
     ~gs_vertexbuffer();
 
     bool gs_vertexbuffer_init_sprite();
+    bool gs_vertexbuffer_init_sprite_batch(size_t num_sprites);
 
     std::shared_ptr<gs_vb_data> gs_vertexbuffer_get_data();
 
     void gs_vertexbuffer_flush();
+    /* uploads only the first num vertices of the buffer's own data */
+    void gs_vertexbuffer_flush_count(size_t num);
     void gs_vertexbuffer_flush_direct(const gs_vb_data *data);
 
     bool gs_load_vb_buffers(attrib_type t, size_t index, GLuint id);
 
-    GLuint gs_vertexbuffer_vao();
+    /* vertex array with this buffer's attributes set up for the program,
+     * configured (and left bound) the first time the pair draws */
+    GLuint gs_vertexbuffer_vao(const std::shared_ptr<gs_program> &program);
 
     size_t gs_vertexbuffer_num();
 
 private:
     bool create_buffers();
-    void gs_vertexbuffer_flush_internal(const gs_vb_data *data);
+    bool init_sprite_buffers(size_t num);
+    void gs_vertexbuffer_flush_internal(const gs_vb_data *data, size_t num);
     GLuint get_vb_buffer(attrib_type type, size_t index, GLint *width, GLenum *gl_type);
 
 private:
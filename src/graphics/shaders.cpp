@@ -729,7 +729,7 @@ uniform vec4 color_vec2;
 
 in vec2 _vertex_shader_attrib0;
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct FragTex {
     vec2 uv;
@@ -766,7 +766,7 @@ void main(void)
     FragTex frag_in;
     frag_in.uv = _vertex_shader_attrib0;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -857,7 +857,7 @@ uniform vec4 color_vec2;
 
 in vec2 _vertex_shader_attrib0;
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct FragTex {
     vec2 uv;
@@ -894,7 +894,7 @@ void main(void)
     FragTex frag_in;
     frag_in.uv = _vertex_shader_attrib0;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -985,7 +985,7 @@ uniform vec4 color_vec2;
 
 in vec2 _vertex_shader_attrib0;
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct FragTex {
     vec2 uv;
@@ -1022,7 +1022,7 @@ void main(void)
     FragTex frag_in;
     frag_in.uv = _vertex_shader_attrib0;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -1115,7 +1115,7 @@ uniform vec4 color_vec2;
 
 in vec2 _vertex_shader_attrib0;
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct VertTexPos {
     vec2 uv;
@@ -1153,7 +1153,7 @@ void main(void)
     frag_in.uv = _vertex_shader_attrib0;
     frag_in.pos = gl_FragCoord;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -1395,7 +1395,7 @@ uniform vec4 color_vec2;
 
 in vec3 _vertex_shader_attrib0;
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct FragPosWide {
     vec3 pos_wide;
@@ -1431,7 +1431,7 @@ void main(void)
     FragPosWide frag_in;
     frag_in.pos_wide = _vertex_shader_attrib0;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -1652,7 +1652,7 @@ uniform vec4 color_vec1;
 uniform vec4 color_vec2;
 
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct FragPos {
     vec4 pos;
@@ -1688,7 +1688,7 @@ void main(void)
     FragPos frag_in;
     frag_in.pos = gl_FragCoord;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -2012,7 +2012,7 @@ uniform vec4 color_vec2;
 
 in vec2 _vertex_shader_attrib0;
 
-out vec3 _pixel_shader_attrib0;
+out vec4 _pixel_shader_attrib0;
 
 struct VertTexPos {
     vec2 uv;
@@ -2048,7 +2048,7 @@ void main(void)
     frag_in.uv = _vertex_shader_attrib0;
     frag_in.pos = gl_FragCoord;
 
-    _pixel_shader_attrib0 = _main_wrap(frag_in);
+    _pixel_shader_attrib0 = vec4(_main_wrap(frag_in), 1.0);
 }
 
 ---------------------------------------
@@ -2489,96 +2489,869 @@ texture2d image null 3 0 18446744073709551615
 ---------------------------------------
 )";
 
-std::string draw_shader = R"(
-Default_Draw
+/* single pass conversion into one texture laid out like the final frame
+ * (Y rows, then the chroma planes), read back with one transfer.  every
+ * rgba texel carries four consecutive bytes of the frame */
+std::string packed_conversion_shaders = R"(
+Convert_Packed_NV12
 ---------------------------------------
+
 const bool obs_glsl_compile = true;
 
-uniform mat4x4 ViewProj;
+struct FragPos {
+    vec4 pos;
+};
 
-in vec4 _input_attrib0;
-in vec2 _input_attrib1;
+FragPos VSPos(uint id)
+{
+    float idHigh = float(id >> 1);
+    float idLow = float(id & uint(1));
 
-out vec2 _vertex_shader_attrib0;
+    float x = idHigh * 4.0 - 1.0;
+    float y = idLow * 4.0 - 1.0;
 
-struct VertInOut {
+    FragPos vert_out;
+    vert_out.pos = vec4(x, y, 0.0, 1.0);
+    return vert_out;
+}
+
+FragPos _main_wrap(uint id)
+{
+    return VSPos(id);
+}
+
+void main(void)
+{
+    uint id;
+    FragPos outputval;
+
+    id = uint(gl_VertexID);
+
+    outputval = _main_wrap(id);
+
+    gl_Position = outputval.pos;
+}
+
+---------------------------------------
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_Packed_NV12
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image;
+uniform vec4 color_vec0;
+uniform vec4 color_vec1;
+uniform vec4 color_vec2;
+uniform int width;
+uniform int height;
+
+
+out vec4 _pixel_shader_attrib0;
+
+vec4 convert4(ivec2 pos, vec4 vec)
+{
+    vec4 val;
+    val.x = dot(vec.xyz, texelFetch(image, pos, 0).rgb);
+    val.y = dot(vec.xyz, texelFetch(image, pos + ivec2(1, 0), 0).rgb);
+    val.z = dot(vec.xyz, texelFetch(image, pos + ivec2(2, 0), 0).rgb);
+    val.w = dot(vec.xyz, texelFetch(image, pos + ivec2(3, 0), 0).rgb);
+    return val + vec.w;
+}
+
+vec3 chroma_rgb(ivec2 pos)
+{
+    vec3 rgb = texelFetch(image, pos, 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 0), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(0, 1), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 1), 0).rgb;
+    return rgb * 0.25;
+}
+
+void main(void)
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy);
+
+    if (pos.y < height) {
+        _pixel_shader_attrib0 = convert4(ivec2(pos.x * 4, pos.y), color_vec0);
+    } else {
+        ivec2 uv_pos = ivec2(pos.x * 4, (pos.y - height) * 2);
+        vec3 rgb0 = chroma_rgb(uv_pos);
+        vec3 rgb1 = chroma_rgb(uv_pos + ivec2(2, 0));
+        _pixel_shader_attrib0 = vec4(dot(color_vec1.xyz, rgb0), dot(color_vec2.xyz, rgb0),
+                                     dot(color_vec1.xyz, rgb1), dot(color_vec2.xyz, rgb1)) +
+                                vec4(color_vec1.w, color_vec2.w, color_vec1.w, color_vec2.w);
+    }
+}
+
+---------------------------------------
+texture2d image null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec0 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec1 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec2 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int width null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int height null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_Packed_I420
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+struct FragPos {
     vec4 pos;
-    vec2 uv;
 };
 
-VertInOut VSDefault(VertInOut vert_in)
+FragPos VSPos(uint id)
 {
-    VertInOut vert_out;
-    vert_out.pos = ((vec4(vert_in.pos.xyz, 1.0)) * (ViewProj));
-    vert_out.uv  = vert_in.uv;
+    float idHigh = float(id >> 1);
+    float idLow = float(id & uint(1));
+
+    float x = idHigh * 4.0 - 1.0;
+    float y = idLow * 4.0 - 1.0;
+
+    FragPos vert_out;
+    vert_out.pos = vec4(x, y, 0.0, 1.0);
     return vert_out;
 }
 
-VertInOut _main_wrap(VertInOut vert_in)
+FragPos _main_wrap(uint id)
 {
-    return VSDefault(vert_in);
+    return VSPos(id);
 }
 
 void main(void)
 {
-    VertInOut vert_in;
-    VertInOut outputval;
+    uint id;
+    FragPos outputval;
 
-    vert_in.pos = _input_attrib0;
-    vert_in.uv = _input_attrib1;
+    id = uint(gl_VertexID);
 
-    outputval = _main_wrap(vert_in);
+    outputval = _main_wrap(id);
 
     gl_Position = outputval.pos;
-    _vertex_shader_attrib0 = outputval.uv;
 }
 
 ---------------------------------------
-float4x4 ViewProj null 3 0 18446744073709551615
 ---------------------------------------
-_input_attrib0 POSITION 1
-+++++++++++++++++++++++++++++++++++++++
-_input_attrib1 TEXCOORD0 1
-+++++++++++++++++++++++++++++++++++++++
-_vertex_shader_attrib0 TEXCOORD0 0
 ---------------------------------------
 =======================================
-Default_Draw
+Convert_Packed_I420
 ---------------------------------------
+
 const bool obs_glsl_compile = true;
 
 uniform sampler2D image;
+uniform vec4 color_vec0;
+uniform vec4 color_vec1;
+uniform vec4 color_vec2;
+uniform int width;
+uniform int height;
 
-in vec2 _vertex_shader_attrib0;
 
 out vec4 _pixel_shader_attrib0;
 
-struct VertInOut {
+vec4 convert4(ivec2 pos, vec4 vec)
+{
+    vec4 val;
+    val.x = dot(vec.xyz, texelFetch(image, pos, 0).rgb);
+    val.y = dot(vec.xyz, texelFetch(image, pos + ivec2(1, 0), 0).rgb);
+    val.z = dot(vec.xyz, texelFetch(image, pos + ivec2(2, 0), 0).rgb);
+    val.w = dot(vec.xyz, texelFetch(image, pos + ivec2(3, 0), 0).rgb);
+    return val + vec.w;
+}
+
+vec3 chroma_rgb(ivec2 pos)
+{
+    vec3 rgb = texelFetch(image, pos, 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 0), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(0, 1), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 1), 0).rgb;
+    return rgb * 0.25;
+}
+
+float chroma_value(int idx)
+{
+    int width_d2 = width / 2;
+    int plane_size = width_d2 * (height / 2);
+    vec4 vec = color_vec1;
+    if (idx >= plane_size) {
+        idx -= plane_size;
+        vec = color_vec2;
+    }
+
+    vec3 rgb = chroma_rgb(ivec2(idx % width_d2, idx / width_d2) * 2);
+    return dot(vec.xyz, rgb) + vec.w;
+}
+
+void main(void)
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy);
+
+    if (pos.y < height) {
+        _pixel_shader_attrib0 = convert4(ivec2(pos.x * 4, pos.y), color_vec0);
+    } else {
+        int idx = (pos.y - height) * width + pos.x * 4;
+        _pixel_shader_attrib0 = vec4(chroma_value(idx), chroma_value(idx + 1),
+                                     chroma_value(idx + 2), chroma_value(idx + 3));
+    }
+}
+
+---------------------------------------
+texture2d image null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec0 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec1 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec2 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int width null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int height null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_Packed_I444
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+struct FragPos {
     vec4 pos;
-    vec2 uv;
 };
 
-vec4 PSDrawBare(VertInOut vert_in)
+FragPos VSPos(uint id)
 {
-    return texture(image, vert_in.uv);
+    float idHigh = float(id >> 1);
+    float idLow = float(id & uint(1));
+
+    float x = idHigh * 4.0 - 1.0;
+    float y = idLow * 4.0 - 1.0;
+
+    FragPos vert_out;
+    vert_out.pos = vec4(x, y, 0.0, 1.0);
+    return vert_out;
 }
 
-vec4 _main_wrap(VertInOut vert_in)
+FragPos _main_wrap(uint id)
 {
-    return PSDrawBare(vert_in);
+    return VSPos(id);
 }
 
 void main(void)
 {
-    VertInOut vert_in;
-    vert_in.pos = gl_FragCoord;
-    vert_in.uv = _vertex_shader_attrib0;
+    uint id;
+    FragPos outputval;
 
-    _pixel_shader_attrib0 = _main_wrap(vert_in);
+    id = uint(gl_VertexID);
+
+    outputval = _main_wrap(id);
+
+    gl_Position = outputval.pos;
 }
 
 ---------------------------------------
-texture2d image null 3 0 0
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_Packed_I444
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image;
+uniform vec4 color_vec0;
+uniform vec4 color_vec1;
+uniform vec4 color_vec2;
+uniform int width;
+uniform int height;
+
+
+out vec4 _pixel_shader_attrib0;
+
+vec4 convert4(ivec2 pos, vec4 vec)
+{
+    vec4 val;
+    val.x = dot(vec.xyz, texelFetch(image, pos, 0).rgb);
+    val.y = dot(vec.xyz, texelFetch(image, pos + ivec2(1, 0), 0).rgb);
+    val.z = dot(vec.xyz, texelFetch(image, pos + ivec2(2, 0), 0).rgb);
+    val.w = dot(vec.xyz, texelFetch(image, pos + ivec2(3, 0), 0).rgb);
+    return val + vec.w;
+}
+
+void main(void)
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy);
+    int plane = pos.y / height;
+    vec4 vec = plane == 0 ? color_vec0 : (plane == 1 ? color_vec1 : color_vec2);
+    _pixel_shader_attrib0 = convert4(ivec2(pos.x * 4, pos.y - plane * height), vec);
+}
+
+---------------------------------------
+texture2d image null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec0 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec1 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec2 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int width null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int height null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+)";
+
+/* single pass conversion writing every plane through multiple render
+ * targets.  for the subsampled formats all targets are drawn at chroma
+ * resolution and the rgba luma target holds two Y rows per texel row, so
+ * it still reads back as a regular Y plane */
+std::string mrt_conversion_shaders = R"(
+Convert_MRT_NV12
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+struct FragPos {
+    vec4 pos;
+};
+
+FragPos VSPos(uint id)
+{
+    float idHigh = float(id >> 1);
+    float idLow = float(id & uint(1));
+
+    float x = idHigh * 4.0 - 1.0;
+    float y = idLow * 4.0 - 1.0;
+
+    FragPos vert_out;
+    vert_out.pos = vec4(x, y, 0.0, 1.0);
+    return vert_out;
+}
+
+FragPos _main_wrap(uint id)
+{
+    return VSPos(id);
+}
+
+void main(void)
+{
+    uint id;
+    FragPos outputval;
+
+    id = uint(gl_VertexID);
+
+    outputval = _main_wrap(id);
+
+    gl_Position = outputval.pos;
+}
+
+---------------------------------------
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_MRT_NV12
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image;
+uniform vec4 color_vec0;
+uniform vec4 color_vec1;
+uniform vec4 color_vec2;
+uniform int width;
+uniform int height;
+
+
+layout(location = 0) out vec4 _pixel_shader_attrib0;
+layout(location = 1) out vec2 _pixel_shader_attrib1;
+
+vec4 convert4(ivec2 pos, vec4 vec)
+{
+    vec4 val;
+    val.x = dot(vec.xyz, texelFetch(image, pos, 0).rgb);
+    val.y = dot(vec.xyz, texelFetch(image, pos + ivec2(1, 0), 0).rgb);
+    val.z = dot(vec.xyz, texelFetch(image, pos + ivec2(2, 0), 0).rgb);
+    val.w = dot(vec.xyz, texelFetch(image, pos + ivec2(3, 0), 0).rgb);
+    return val + vec.w;
+}
+
+vec3 chroma_rgb(ivec2 pos)
+{
+    vec3 rgb = texelFetch(image, pos, 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 0), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(0, 1), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 1), 0).rgb;
+    return rgb * 0.25;
+}
+
+void main(void)
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy);
+    int width_d4 = width / 4;
+    int row = pos.y * 2 + (pos.x >= width_d4 ? 1 : 0);
+    vec3 rgb = chroma_rgb(pos * 2);
+
+    _pixel_shader_attrib0 = convert4(ivec2((pos.x % width_d4) * 4, row), color_vec0);
+    _pixel_shader_attrib1 = vec2(dot(color_vec1.xyz, rgb) + color_vec1.w,
+                                 dot(color_vec2.xyz, rgb) + color_vec2.w);
+}
+
+---------------------------------------
+texture2d image null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec0 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec1 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec2 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int width null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int height null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_MRT_I420
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+struct FragPos {
+    vec4 pos;
+};
+
+FragPos VSPos(uint id)
+{
+    float idHigh = float(id >> 1);
+    float idLow = float(id & uint(1));
+
+    float x = idHigh * 4.0 - 1.0;
+    float y = idLow * 4.0 - 1.0;
+
+    FragPos vert_out;
+    vert_out.pos = vec4(x, y, 0.0, 1.0);
+    return vert_out;
+}
+
+FragPos _main_wrap(uint id)
+{
+    return VSPos(id);
+}
+
+void main(void)
+{
+    uint id;
+    FragPos outputval;
+
+    id = uint(gl_VertexID);
+
+    outputval = _main_wrap(id);
+
+    gl_Position = outputval.pos;
+}
+
+---------------------------------------
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_MRT_I420
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image;
+uniform vec4 color_vec0;
+uniform vec4 color_vec1;
+uniform vec4 color_vec2;
+uniform int width;
+uniform int height;
+
+
+layout(location = 0) out vec4 _pixel_shader_attrib0;
+layout(location = 1) out float _pixel_shader_attrib1;
+layout(location = 2) out float _pixel_shader_attrib2;
+
+vec4 convert4(ivec2 pos, vec4 vec)
+{
+    vec4 val;
+    val.x = dot(vec.xyz, texelFetch(image, pos, 0).rgb);
+    val.y = dot(vec.xyz, texelFetch(image, pos + ivec2(1, 0), 0).rgb);
+    val.z = dot(vec.xyz, texelFetch(image, pos + ivec2(2, 0), 0).rgb);
+    val.w = dot(vec.xyz, texelFetch(image, pos + ivec2(3, 0), 0).rgb);
+    return val + vec.w;
+}
+
+vec3 chroma_rgb(ivec2 pos)
+{
+    vec3 rgb = texelFetch(image, pos, 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 0), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(0, 1), 0).rgb;
+    rgb += texelFetch(image, pos + ivec2(1, 1), 0).rgb;
+    return rgb * 0.25;
+}
+
+void main(void)
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy);
+    int width_d4 = width / 4;
+    int row = pos.y * 2 + (pos.x >= width_d4 ? 1 : 0);
+    vec3 rgb = chroma_rgb(pos * 2);
+
+    _pixel_shader_attrib0 = convert4(ivec2((pos.x % width_d4) * 4, row), color_vec0);
+    _pixel_shader_attrib1 = dot(color_vec1.xyz, rgb) + color_vec1.w;
+    _pixel_shader_attrib2 = dot(color_vec2.xyz, rgb) + color_vec2.w;
+}
+
+---------------------------------------
+texture2d image null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec0 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec1 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec2 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int width null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int height null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_MRT_I444
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+struct FragPos {
+    vec4 pos;
+};
+
+FragPos VSPos(uint id)
+{
+    float idHigh = float(id >> 1);
+    float idLow = float(id & uint(1));
+
+    float x = idHigh * 4.0 - 1.0;
+    float y = idLow * 4.0 - 1.0;
+
+    FragPos vert_out;
+    vert_out.pos = vec4(x, y, 0.0, 1.0);
+    return vert_out;
+}
+
+FragPos _main_wrap(uint id)
+{
+    return VSPos(id);
+}
+
+void main(void)
+{
+    uint id;
+    FragPos outputval;
+
+    id = uint(gl_VertexID);
+
+    outputval = _main_wrap(id);
+
+    gl_Position = outputval.pos;
+}
+
+---------------------------------------
+---------------------------------------
+---------------------------------------
+=======================================
+Convert_MRT_I444
+---------------------------------------
+
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image;
+uniform vec4 color_vec0;
+uniform vec4 color_vec1;
+uniform vec4 color_vec2;
+uniform int width;
+uniform int height;
+
+
+layout(location = 0) out vec4 _pixel_shader_attrib0;
+layout(location = 1) out vec4 _pixel_shader_attrib1;
+layout(location = 2) out vec4 _pixel_shader_attrib2;
+
+vec4 convert4(ivec2 pos, vec4 vec)
+{
+    vec4 val;
+    val.x = dot(vec.xyz, texelFetch(image, pos, 0).rgb);
+    val.y = dot(vec.xyz, texelFetch(image, pos + ivec2(1, 0), 0).rgb);
+    val.z = dot(vec.xyz, texelFetch(image, pos + ivec2(2, 0), 0).rgb);
+    val.w = dot(vec.xyz, texelFetch(image, pos + ivec2(3, 0), 0).rgb);
+    return val + vec.w;
+}
+
+void main(void)
+{
+    ivec2 pos = ivec2(gl_FragCoord.xy) * ivec2(4, 1);
+
+    _pixel_shader_attrib0 = convert4(pos, color_vec0);
+    _pixel_shader_attrib1 = convert4(pos, color_vec1);
+    _pixel_shader_attrib2 = convert4(pos, color_vec2);
+}
+
+---------------------------------------
+texture2d image null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec0 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec1 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+float4 color_vec2 null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int width null 3 0 18446744073709551615
++++++++++++++++++++++++++++++++++++++++
+int height null 3 0 18446744073709551615
+---------------------------------------
+---------------------------------------
+)";
+
+std::string draw_shader = R"(
+Default_Draw
+---------------------------------------
+const bool obs_glsl_compile = true;
+
+uniform mat4x4 ViewProj;
+
+in vec4 _input_attrib0;
+in vec2 _input_attrib1;
+
+out vec2 _vertex_shader_attrib0;
+
+struct VertInOut {
+    vec4 pos;
+    vec2 uv;
+};
+
+VertInOut VSDefault(VertInOut vert_in)
+{
+    VertInOut vert_out;
+    vert_out.pos = ((vec4(vert_in.pos.xyz, 1.0)) * (ViewProj));
+    vert_out.uv  = vert_in.uv;
+    return vert_out;
+}
+
+VertInOut _main_wrap(VertInOut vert_in)
+{
+    return VSDefault(vert_in);
+}
+
+void main(void)
+{
+    VertInOut vert_in;
+    VertInOut outputval;
+
+    vert_in.pos = _input_attrib0;
+    vert_in.uv = _input_attrib1;
+
+    outputval = _main_wrap(vert_in);
+
+    gl_Position = outputval.pos;
+    _vertex_shader_attrib0 = outputval.uv;
+}
+
+---------------------------------------
+float4x4 ViewProj null 3 0 18446744073709551615
+---------------------------------------
+_input_attrib0 POSITION 1
++++++++++++++++++++++++++++++++++++++++
+_input_attrib1 TEXCOORD0 1
++++++++++++++++++++++++++++++++++++++++
+_vertex_shader_attrib0 TEXCOORD0 0
+---------------------------------------
+=======================================
+Default_Draw
+---------------------------------------
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image;
+
+in vec2 _vertex_shader_attrib0;
+
+out vec4 _pixel_shader_attrib0;
+
+struct VertInOut {
+    vec4 pos;
+    vec2 uv;
+};
+
+vec4 PSDrawBare(VertInOut vert_in)
+{
+    return texture(image, vert_in.uv);
+}
+
+vec4 _main_wrap(VertInOut vert_in)
+{
+    return PSDrawBare(vert_in);
+}
+
+void main(void)
+{
+    VertInOut vert_in;
+    vert_in.pos = gl_FragCoord;
+    vert_in.uv = _vertex_shader_attrib0;
+
+    _pixel_shader_attrib0 = _main_wrap(vert_in);
+}
+
+---------------------------------------
+texture2d image null 3 0 0
+---------------------------------------
+---------------------------------------
+def_sampler
+=======================================
+Default_Draw_Batch
+---------------------------------------
+const bool obs_glsl_compile = true;
+
+uniform mat4x4 ViewProj;
+
+in vec4 _input_attrib0;
+in vec2 _input_attrib1;
+
+out vec2 _vertex_shader_attrib0;
+flat out int _vertex_shader_attrib1;
+
+struct VertInOut {
+    vec4 pos;
+    vec2 uv;
+    int slot;
+};
+
+VertInOut VSDrawBatch(VertInOut vert_in)
+{
+    VertInOut vert_out;
+    vert_out.pos = ((vec4(vert_in.pos.xy, 0.0, 1.0)) * (ViewProj));
+    vert_out.uv  = vert_in.uv;
+    vert_out.slot = int(vert_in.pos.w);
+    return vert_out;
+}
+
+VertInOut _main_wrap(VertInOut vert_in)
+{
+    return VSDrawBatch(vert_in);
+}
+
+void main(void)
+{
+    VertInOut vert_in;
+    VertInOut outputval;
+
+    vert_in.pos = _input_attrib0;
+    vert_in.uv = _input_attrib1;
+    vert_in.slot = 0;
+
+    outputval = _main_wrap(vert_in);
+
+    gl_Position = outputval.pos;
+    _vertex_shader_attrib0 = outputval.uv;
+    _vertex_shader_attrib1 = outputval.slot;
+}
+
+---------------------------------------
+float4x4 ViewProj null 3 0 18446744073709551615
+---------------------------------------
+_input_attrib0 POSITION 1
++++++++++++++++++++++++++++++++++++++++
+_input_attrib1 TEXCOORD0 1
++++++++++++++++++++++++++++++++++++++++
+_vertex_shader_attrib0 TEXCOORD0 0
++++++++++++++++++++++++++++++++++++++++
+_vertex_shader_attrib1 TEXCOORD1 0
+---------------------------------------
+=======================================
+Default_Draw_Batch
+---------------------------------------
+const bool obs_glsl_compile = true;
+
+uniform sampler2D image0;
+uniform sampler2D image1;
+uniform sampler2D image2;
+uniform sampler2D image3;
+uniform sampler2D image4;
+uniform sampler2D image5;
+uniform sampler2D image6;
+uniform sampler2D image7;
+
+in vec2 _vertex_shader_attrib0;
+flat in int _vertex_shader_attrib1;
+
+out vec4 _pixel_shader_attrib0;
+
+struct VertInOut {
+    vec4 pos;
+    vec2 uv;
+    int slot;
+};
+
+vec4 PSDrawBatch(VertInOut vert_in)
+{
+    int slot = vert_in.slot;
+    if (slot == 0)
+        return texture(image0, vert_in.uv);
+    if (slot == 1)
+        return texture(image1, vert_in.uv);
+    if (slot == 2)
+        return texture(image2, vert_in.uv);
+    if (slot == 3)
+        return texture(image3, vert_in.uv);
+    if (slot == 4)
+        return texture(image4, vert_in.uv);
+    if (slot == 5)
+        return texture(image5, vert_in.uv);
+    if (slot == 6)
+        return texture(image6, vert_in.uv);
+    return texture(image7, vert_in.uv);
+}
+
+vec4 _main_wrap(VertInOut vert_in)
+{
+    return PSDrawBatch(vert_in);
+}
+
+void main(void)
+{
+    VertInOut vert_in;
+    vert_in.pos = gl_FragCoord;
+    vert_in.uv = _vertex_shader_attrib0;
+    vert_in.slot = _vertex_shader_attrib1;
+
+    _pixel_shader_attrib0 = _main_wrap(vert_in);
+}
+
+---------------------------------------
+texture2d image0 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image1 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image2 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image3 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image4 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image5 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image6 null 3 0 0
++++++++++++++++++++++++++++++++++++++++
+texture2d image7 null 3 0 0
 ---------------------------------------
 ---------------------------------------
 def_sampler
@@ -2791,6 +3564,8 @@ std::string conversion_shaders_total =
         conversion_shaders3 + "=======================================" +
         conversion_shaders4 + "=======================================" +
         conversion_shaders5 + "=======================================" +
+        packed_conversion_shaders + "=======================================" +
+        mrt_conversion_shaders + "=======================================" +
         scale_shader + "=======================================" +
         draw_shader;
 
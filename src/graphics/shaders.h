@@ -1,6 +1,7 @@
 #pragma once
 
 #include "gs_shader_info.h"
+#include <string.h>
 
 static enum gs_shader_param_type get_shader_param_type(const char *type)
 {
@@ -1,12 +1,18 @@
 #ifndef LITEOBS2_GLOBAL_H
 #define LITEOBS2_GLOBAL_H
 
-#include <QtCore/qglobal.h>
+#if defined(_WIN32)
+#  define LITEOBS2_DECL_EXPORT __declspec(dllexport)
+#  define LITEOBS2_DECL_IMPORT __declspec(dllimport)
+#else
+#  define LITEOBS2_DECL_EXPORT __attribute__((visibility("default")))
+#  define LITEOBS2_DECL_IMPORT __attribute__((visibility("default")))
+#endif
 
 #if defined(LITEOBS2_LIBRARY)
-#  define LITEOBS2_EXPORT Q_DECL_EXPORT
+#  define LITEOBS2_EXPORT LITEOBS2_DECL_EXPORT
 #else
-#  define LITEOBS2_EXPORT Q_DECL_IMPORT
+#  define LITEOBS2_EXPORT LITEOBS2_DECL_IMPORT
 #endif
 
 #endif // LITEOBS2_GLOBAL_H
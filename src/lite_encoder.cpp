@@ -7,6 +7,7 @@
 #include "media-io/audio_output.h"
 #include "util/circlebuf.h"
 #include "util/log.h"
+#include "util/trace.h"
 #include <mutex>
 #include <atomic>
 #include <list>
@@ -46,6 +47,7 @@ struct lite_obs_encoder_private
 
     circlebuf audio_input_buffer[MAX_AV_PLANES]{};
     uint8_t *audio_output_buffer[MAX_AV_PLANES]{};
+    std::atomic<uint32_t> buffered_samples{};
 
     /* if a video encoder is paired with an audio encoder, make it start
          * up at the specific timestamp.  if this is the audio encoder,
@@ -201,6 +203,7 @@ void lite_obs_encoder::clear_audio()
 {
     for (size_t i = 0; i < d_ptr->planes; i++)
         circlebuf_free(&d_ptr->audio_input_buffer[i]);
+    d_ptr->buffered_samples = 0;
 }
 
 size_t lite_obs_encoder::calc_offset_size(uint64_t v_start_ts, uint64_t a_start_ts)
@@ -292,22 +295,43 @@ fail:
 bool lite_obs_encoder::send_audio_data()
 {
     struct encoder_frame enc_frame;
+    bool contiguous = true;
 
     memset(&enc_frame, 0, sizeof(struct encoder_frame));
 
+    /* the mixer's block size rarely matches the encoder frame size, so
+     * frames are cut out of the input buffer.  when a frame does not wrap
+     * around the end of the buffer it is encoded in place, otherwise it is
+     * gathered into audio_output_buffer */
     for (size_t i = 0; i < d_ptr->planes; i++) {
-        circlebuf_pop_front(&d_ptr->audio_input_buffer[i],
-                            d_ptr->audio_output_buffer[i],
-                            d_ptr->framesize_bytes);
+        circlebuf *cb = &d_ptr->audio_input_buffer[i];
+        if (cb->start_pos + d_ptr->framesize_bytes > cb->capacity)
+            contiguous = false;
+    }
+
+    for (size_t i = 0; i < d_ptr->planes; i++) {
+        circlebuf *cb = &d_ptr->audio_input_buffer[i];
 
-        enc_frame.data[i] = d_ptr->audio_output_buffer[i];
+        if (contiguous) {
+            enc_frame.data[i] = (uint8_t *)circlebuf_data(cb, 0);
+        } else {
+            circlebuf_peek_front(cb, d_ptr->audio_output_buffer[i],
+                                 d_ptr->framesize_bytes);
+            enc_frame.data[i] = d_ptr->audio_output_buffer[i];
+        }
         enc_frame.linesize[i] = (uint32_t)d_ptr->framesize_bytes;
     }
 
     enc_frame.frames = (uint32_t)d_ptr->framesize;
     enc_frame.pts = d_ptr->cur_pts;
 
-    if (!do_encode(&enc_frame))
+    bool success = do_encode(&enc_frame);
+
+    for (size_t i = 0; i < d_ptr->planes; i++)
+        circlebuf_pop_front(&d_ptr->audio_input_buffer[i], NULL,
+                            d_ptr->framesize_bytes);
+
+    if (!success)
         return false;
 
     d_ptr->cur_pts += d_ptr->framesize;
@@ -324,14 +348,16 @@ void lite_obs_encoder::receive_audio_internal(size_t mix_idx, struct audio_data
         clear_audio();
     }
 
-    if (!buffer_audio(&audio))
-        return;
-
-    while (d_ptr->audio_input_buffer[0].size >= d_ptr->framesize_bytes) {
-        if (!send_audio_data()) {
-            break;
+    if (buffer_audio(&audio)) {
+        while (d_ptr->audio_input_buffer[0].size >= d_ptr->framesize_bytes) {
+            if (!send_audio_data()) {
+                break;
+            }
         }
     }
+
+    if (d_ptr->blocksize)
+        d_ptr->buffered_samples = (uint32_t)(d_ptr->audio_input_buffer[0].size / d_ptr->blocksize);
 }
 
 void lite_obs_encoder::receive_audio(void *param, size_t mix_idx, struct audio_data *data)
@@ -404,7 +430,8 @@ void lite_obs_encoder::remove_connection(bool shutdown)
 {
     if (i_encoder_type() == obs_encoder_type::OBS_ENCODER_AUDIO) {
         auto ao = d_ptr->a_media.lock();
-        ao->audio_output_disconnect(d_ptr->mixer_idx, lite_obs_encoder::receive_audio, this);
+        if (ao)
+            ao->audio_output_disconnect(d_ptr->mixer_idx, lite_obs_encoder::receive_audio, this);
     } else {
         if (i_gpu_encode_available()) {
             stop_gpu_encode();
@@ -555,6 +582,7 @@ void lite_obs_encoder::stop_gpu_encode()
 
 bool lite_obs_encoder::do_encode(encoder_frame *frame)
 {
+    TRACE_SCOPE("encoder_do_encode");
     auto pkt = std::make_shared<encoder_packet>();
     bool received = false;
     bool success;
@@ -817,6 +845,15 @@ bool lite_obs_encoder::lite_obs_encoder_active()
     return d_ptr->active;
 }
 
+uint32_t lite_obs_encoder::lite_obs_encoder_queue_depth()
+{
+    if (i_encoder_type() == obs_encoder_type::OBS_ENCODER_AUDIO)
+        return d_ptr->buffered_samples;
+
+    auto vo = d_ptr->v_media.lock();
+    return vo ? vo->video_output_get_cached_frames() : 0;
+}
+
 std::shared_ptr<lite_obs_encoder> lite_obs_encoder::lite_obs_encoder_paired_encoder()
 {
     return d_ptr->paired_encoder.lock();
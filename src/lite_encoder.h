@@ -50,6 +50,9 @@ public:
     std::shared_ptr<audio_output> lite_obs_encoder_audio();
 
     bool lite_obs_encoder_active();
+    /* video: raw frames waiting in the video output cache,
+     * audio: raw samples buffered ahead of the next encoder frame */
+    uint32_t lite_obs_encoder_queue_depth();
     std::shared_ptr<lite_obs_encoder> lite_obs_encoder_paired_encoder();
     void lite_obs_encoder_set_paired_encoder(std::shared_ptr<lite_obs_encoder> encoder);
     void lite_obs_encoder_set_lock(bool lock);
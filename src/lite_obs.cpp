@@ -1,6 +1,7 @@
 #include "lite_obs.h"
 #include <mutex>
-#include <list>
+#include <atomic>
+#include <algorithm>
 
 #include "media-io/video_output.h"
 
@@ -11,21 +12,49 @@
 #include "graphics/gs_stagesurf.h"
 
 #include "util/log.h"
+#include "util/atomic_shared_ptr.h"
 #include "obs-defs.h"
 #include "lite_obs_core_video.h"
 #include "lite_obs_core_audio.h"
 
 lite_obs obs;
 
+/* the source arrays are immutable once published.  readers take the
+ * current one with a single atomic load, writers copy it, change the copy
+ * and publish that; a replaced array is freed when its last reader drops
+ * its reference */
 struct lite_obs_data
 {
-    std::recursive_mutex sources_mutex;
-    std::recursive_mutex audio_sources_mutex;
+    std::mutex sources_mutex; /* serializes writers only */
 
-    std::list<std::shared_ptr<lite_source>> sources{};
-    std::list<std::shared_ptr<lite_source>> audio_sources{};
+    atomic_shared_ptr<const lite_source_array> sources{std::make_shared<const lite_source_array>()};
+    atomic_shared_ptr<const lite_source_array> audio_sources{std::make_shared<const lite_source_array>()};
 };
 
+static std::shared_ptr<const lite_source_array> source_array_add(const std::shared_ptr<const lite_source_array> &array,
+                                                                 const std::shared_ptr<lite_source> &source)
+{
+    auto new_array = std::make_shared<lite_source_array>();
+    new_array->reserve(array->size() + 1);
+    new_array->assign(array->begin(), array->end());
+    new_array->push_back(source);
+    return new_array;
+}
+
+static std::shared_ptr<const lite_source_array> source_array_remove(const std::shared_ptr<const lite_source_array> &array,
+                                                                    const std::shared_ptr<lite_source> &source)
+{
+    auto iter = std::find(array->begin(), array->end(), source);
+    if (iter == array->end())
+        return nullptr;
+
+    auto new_array = std::make_shared<lite_source_array>();
+    new_array->reserve(array->size() - 1);
+    new_array->insert(new_array->end(), array->begin(), iter);
+    new_array->insert(new_array->end(), iter + 1, array->end());
+    return new_array;
+}
+
 struct lite_obs_private
 {
     lite_obs_data data{};
@@ -45,36 +74,37 @@ lite_obs::~lite_obs()
 
 void lite_obs::add_source(std::shared_ptr<lite_source> source, bool is_audio_source)
 {
-    if (is_audio_source) {
-        std::lock_guard<std::recursive_mutex> lock(d_ptr->data.audio_sources_mutex);
-        d_ptr->data.audio_sources.push_back(source);
-    }
+    auto &data = d_ptr->data;
+    std::lock_guard<std::mutex> lock(data.sources_mutex);
+
+    if (is_audio_source)
+        data.audio_sources.store(source_array_add(data.audio_sources.load(), source));
 
-    std::lock_guard<std::recursive_mutex> lock(d_ptr->data.sources_mutex);
-    d_ptr->data.sources.push_back(source);
+    data.sources.store(source_array_add(data.sources.load(), source));
 }
 
 void lite_obs::remove_source(std::shared_ptr<lite_source> source)
 {
-    {
-        std::lock_guard<std::recursive_mutex> lock(d_ptr->data.audio_sources_mutex);
-        for (auto iter = d_ptr->data.audio_sources.begin(); iter != d_ptr->data.audio_sources.end(); iter++) {
-            if (source == *iter) {
-                d_ptr->data.audio_sources.erase(iter);
-                break;
-            }
-        }
-    }
+    auto &data = d_ptr->data;
+    std::lock_guard<std::mutex> lock(data.sources_mutex);
 
-    {
-        std::lock_guard<std::recursive_mutex> lock(d_ptr->data.sources_mutex);
-        for (auto iter = d_ptr->data.sources.begin(); iter != d_ptr->data.sources.end(); iter++) {
-            if (source == *iter) {
-                d_ptr->data.sources.erase(iter);
-                break;
-            }
-        }
-    }
+    auto audio_sources = source_array_remove(data.audio_sources.load(), source);
+    if (audio_sources)
+        data.audio_sources.store(std::move(audio_sources));
+
+    auto sources = source_array_remove(data.sources.load(), source);
+    if (sources)
+        data.sources.store(std::move(sources));
+}
+
+std::shared_ptr<const lite_source_array> lite_obs::sources()
+{
+    return d_ptr->data.sources.load();
+}
+
+std::shared_ptr<const lite_source_array> lite_obs::audio_sources()
+{
+    return d_ptr->data.audio_sources.load();
 }
 
 #define OBS_SIZE_MIN 2
@@ -135,6 +165,13 @@ lite_obs_core_audio *lite_obs::obs_core_audio()
     return &d_ptr->audio;
 }
 
+void lite_obs::obs_get_stats(obs_stats *stats, bool reset_histograms)
+{
+    *stats = obs_stats{};
+    d_ptr->video.lite_obs_core_video_get_stats(stats, reset_histograms);
+    d_ptr->audio.lite_obs_core_audio_get_stats(stats, reset_histograms);
+}
+
 void lite_obs::obs_shutdown()
 {
     d_ptr->video.lite_obs_stop_video();
@@ -3,6 +3,7 @@
 
 #include "lite_obs_info.h"
 #include <memory>
+#include <vector>
 
 
 
@@ -14,6 +15,9 @@ class video_output;
 class audio_output;
 class lite_obs_core_video;
 class lite_obs_core_audio;
+
+typedef std::vector<std::shared_ptr<lite_source>> lite_source_array;
+
 class lite_obs
 {
 public:
@@ -23,6 +27,11 @@ public:
     void add_source(std::shared_ptr<lite_source> source, bool is_audio_source);
     void remove_source(std::shared_ptr<lite_source> source);
 
+    /* immutable snapshots of the registered sources, safe to walk from
+     * any thread and never blocked by add_source/remove_source */
+    std::shared_ptr<const lite_source_array> sources();
+    std::shared_ptr<const lite_source_array> audio_sources();
+
     int obs_reset_video(obs_video_info *ovi);
     bool obs_reset_audio(const obs_audio_info *oai);
 
@@ -32,6 +41,10 @@ public:
     lite_obs_core_video *obs_core_video();
     lite_obs_core_audio *obs_core_audio();
 
+    /* lock-free, safe to poll from any thread; reset_histograms starts a
+     * new histogram interval */
+    void obs_get_stats(obs_stats *stats, bool reset_histograms = false);
+
     void obs_shutdown();
 
 private:
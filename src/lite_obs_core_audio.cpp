@@ -1,8 +1,13 @@
 #include "lite_obs_core_audio.h"
 #include "lite_obs_info.h"
+#include "lite_obs.h"
+#include "lite_source.h"
 #include "media-io/audio_output.h"
 #include "util/circlebuf.h"
 #include "util/log.h"
+#include "util/atomic_shared_ptr.h"
+#include <atomic>
+#include <vector>
 
 struct ts_info {
     uint64_t start;
@@ -10,16 +15,25 @@ struct ts_info {
 };
 
 #define DEBUG_AUDIO 0
-#define MAX_BUFFERING_TICKS 45
+/* the block size is configurable, so the buffering cap is a duration */
+#define MAX_BUFFERING_NS 1000000000ULL
 
 struct lite_obs_core_audio_private
 {
-    std::shared_ptr<audio_output> audio{};
+    atomic_shared_ptr<audio_output> audio{};
 
     uint64_t buffered_ts{};
     circlebuf buffered_timestamps{};
-    uint64_t buffering_wait_ticks{};
-    int total_buffering_ticks{};
+    std::atomic<uint64_t> buffering_wait_ticks{};
+    std::atomic_int total_buffering_ticks{};
+    int max_buffering_ticks{};
+    bool max_buffering_logged{};
+    std::atomic<uint64_t> ticks{};
+
+    /* audio sources snapshot for the current tick, and which mixes each
+     * of them clamps as the last source mixed in */
+    std::shared_ptr<const lite_source_array> render_order{};
+    std::vector<uint32_t> clamp_mixers{};
 };
 
 lite_obs_core_audio::lite_obs_core_audio()
@@ -34,82 +48,151 @@ lite_obs_core_audio::~lite_obs_core_audio()
 
 std::shared_ptr<audio_output> lite_obs_core_audio::core_audio()
 {
-    return d_ptr->audio;
+    return d_ptr->audio.load();
 }
 
-bool lite_obs_core_audio::audio_callback_internal(uint64_t start_ts_in, uint64_t end_ts_in,
-                                                  uint64_t *out_ts, uint32_t mixers,
-                                                  audio_output_data *mixes)
+static inline bool audio_in_block(uint64_t ts, const ts_info &block)
 {
-    size_t sample_rate = d_ptr->audio->audio_output_get_sample_rate();
-    size_t channels = d_ptr->audio->audio_output_get_channels();
-    ts_info ts = {start_ts_in, end_ts_in};
-    size_t audio_size;
-    uint64_t min_ts;
+    return ts && ts + 1 >= block.start && ts < block.end;
+}
 
-    circlebuf_push_back(&d_ptr->buffered_timestamps, &ts, sizeof(ts));
-    circlebuf_peek_front(&d_ptr->buffered_timestamps, &ts, sizeof(ts));
-    min_ts = ts.start;
+void lite_obs_core_audio::add_audio_buffering(size_t sample_rate, uint32_t frames,
+                                              ts_info *ts, uint64_t min_ts)
+{
+    uint64_t offset = ts->start - min_ts;
+
+    if (d_ptr->total_buffering_ticks == d_ptr->max_buffering_ticks) {
+        /* the late source is mixed late or dropped from here on */
+        if (!d_ptr->max_buffering_logged) {
+            blog(LOG_WARNING, "audio source is %d milliseconds behind the maximum audio buffering",
+                 (int)(offset / 1000000));
+            d_ptr->max_buffering_logged = true;
+        }
+        return;
+    }
 
-    audio_size = AUDIO_OUTPUT_FRAMES * sizeof(float);
+    uint64_t total = ns_to_audio_frames(sample_rate, offset);
+    int ticks = (int)((total + frames - 1) / frames);
 
-//    /* ------------------------------------------------ */
-//    /* render audio data */
-//    for (size_t i = 0; i < audio->render_order.num; i++) {
-//        obs_source_t *source = audio->render_order.array[i];
-//        obs_source_audio_render(source, mixers, channels, sample_rate,
-//                                audio_size);
-//    }
+    d_ptr->total_buffering_ticks += ticks;
+    if (d_ptr->total_buffering_ticks >= d_ptr->max_buffering_ticks) {
+        ticks -= d_ptr->total_buffering_ticks - d_ptr->max_buffering_ticks;
+        d_ptr->total_buffering_ticks = d_ptr->max_buffering_ticks;
+        blog(LOG_WARNING, "Max audio buffering reached!");
+    }
 
-//    /* ------------------------------------------------ */
-//    /* get minimum audio timestamp */
-//    pthread_mutex_lock(&data->audio_sources_mutex);
-//    const char *buffering_name = calc_min_ts(data, sample_rate, &min_ts);
-//    pthread_mutex_unlock(&data->audio_sources_mutex);
+    int ms = (int)(audio_frames_to_ns(sample_rate, (uint64_t)ticks * frames) / 1000000);
+    int total_ms = (int)(audio_frames_to_ns(sample_rate, (uint64_t)d_ptr->total_buffering_ticks * frames) / 1000000);
+    blog(LOG_INFO, "adding %d milliseconds of audio buffering, total "
+                   "audio buffering is now %d milliseconds",
+         ms, total_ms);
+
+    /* queue the blocks before this one again, they are processed without
+     * output while the sources catch up, which keeps the output timeline
+     * gapless */
+    if (!d_ptr->buffering_wait_ticks)
+        d_ptr->buffered_ts = ts->start;
+
+    ts_info new_ts{};
+    uint64_t waiting = d_ptr->buffering_wait_ticks;
+    for (int i = 0; i < ticks; i++) {
+        waiting++;
+        new_ts.end = d_ptr->buffered_ts - audio_frames_to_ns(sample_rate, (waiting - 1) * frames);
+        new_ts.start = d_ptr->buffered_ts - audio_frames_to_ns(sample_rate, waiting * frames);
+        circlebuf_push_front(&d_ptr->buffered_timestamps, &new_ts, sizeof(new_ts));
+    }
 
-//    /* ------------------------------------------------ */
-//    /* if a source has gone backward in time, buffer */
-//    if (min_ts < ts.start)
-//        add_audio_buffering(audio, sample_rate, &ts, min_ts,
-//                            buffering_name);
+    d_ptr->buffering_wait_ticks = waiting;
+    *ts = new_ts;
+}
 
-//    /* ------------------------------------------------ */
-//    /* mix audio */
-//    if (!audio->buffering_wait_ticks) {
-//        for (size_t i = 0; i < audio->root_nodes.num; i++) {
-//            obs_source_t *source = audio->root_nodes.array[i];
+void lite_obs_core_audio::mix_audio(audio_output_data *mixes, uint32_t mixers, size_t channels,
+                                    size_t sample_rate, uint32_t frames, const ts_info &ts)
+{
+    auto &sources = *d_ptr->render_order;
+    d_ptr->clamp_mixers.assign(sources.size(), 0);
+
+    /* the last source mixed into each mix clamps it in the same pass, a
+     * mix no source reached stays silent and needs no clamp at all */
+    uint32_t unclamped = mixers;
+    for (size_t i = sources.size(); i > 0 && unclamped; i--) {
+        uint64_t source_ts;
+        uint32_t source_mixers;
+
+        if (!sources[i - 1]->audio_rendered(&source_ts, &source_mixers) ||
+                !audio_in_block(source_ts, ts))
+            continue;
+
+        d_ptr->clamp_mixers[i - 1] = source_mixers & unclamped;
+        unclamped &= ~source_mixers;
+    }
 
-//            if (source->audio_pending)
-//                continue;
+    for (size_t i = 0; i < sources.size(); i++) {
+        uint64_t source_ts;
+        uint32_t source_mixers;
 
-//            pthread_mutex_lock(&source->audio_buf_mutex);
+        if (!sources[i]->audio_rendered(&source_ts, &source_mixers) ||
+                !audio_in_block(source_ts, ts))
+            continue;
 
-//            if (source->audio_output_buf[0][0] && source->audio_ts)
-//                mix_audio(mixes, source, channels, sample_rate,
-//                          &ts);
+        source_mixers &= mixers;
+        if (source_mixers)
+            sources[i]->audio_mix(mixes, source_mixers, d_ptr->clamp_mixers[i],
+                                  channels, sample_rate, frames, ts.start);
+    }
+}
 
-//            pthread_mutex_unlock(&source->audio_buf_mutex);
-//        }
-//    }
+bool lite_obs_core_audio::audio_callback_internal(uint64_t start_ts_in, uint64_t end_ts_in,
+                                                  uint64_t *out_ts, uint32_t mixers,
+                                                  audio_output_data *mixes)
+{
+    auto audio = d_ptr->audio.load();
+    size_t sample_rate = audio->audio_output_get_sample_rate();
+    size_t channels = audio->audio_output_get_channels();
+    uint32_t frames = audio->audio_output_get_frames_per_block();
+    ts_info ts = {start_ts_in, end_ts_in};
+    uint64_t min_ts;
 
-//    /* ------------------------------------------------ */
-//    /* discard audio */
-//    pthread_mutex_lock(&data->audio_sources_mutex);
+    circlebuf_push_back(&d_ptr->buffered_timestamps, &ts, sizeof(ts));
+    circlebuf_peek_front(&d_ptr->buffered_timestamps, &ts, sizeof(ts));
+    min_ts = ts.start;
+    d_ptr->ticks++;
+
+    /* ------------------------------------------------ */
+    /* render audio data */
+    d_ptr->render_order = obs.audio_sources();
+    for (auto &source : *d_ptr->render_order)
+        source->audio_render(channels, frames);
+
+    /* ------------------------------------------------ */
+    /* get minimum audio timestamp */
+    for (auto &source : *d_ptr->render_order) {
+        uint64_t source_ts;
+        uint32_t source_mixers;
+
+        if (source->audio_rendered(&source_ts, &source_mixers) &&
+                source_ts && source_ts < min_ts)
+            min_ts = source_ts;
+    }
 
-//    source = data->first_audio_source;
-//    while (source) {
-//        pthread_mutex_lock(&source->audio_buf_mutex);
-//        discard_audio(audio, source, channels, sample_rate, &ts);
-//        pthread_mutex_unlock(&source->audio_buf_mutex);
+    /* ------------------------------------------------ */
+    /* if a source has gone backward in time, buffer */
+    if (min_ts < ts.start)
+        add_audio_buffering(sample_rate, frames, &ts, min_ts);
 
-//        source = (struct obs_source *)source->next_audio_source;
-//    }
+    /* ------------------------------------------------ */
+    /* mix audio */
+    if (!d_ptr->buffering_wait_ticks)
+        mix_audio(mixes, mixers, channels, sample_rate, frames, ts);
 
-//    pthread_mutex_unlock(&data->audio_sources_mutex);
+    /* ------------------------------------------------ */
+    /* discard audio */
+    for (auto &source : *d_ptr->render_order)
+        source->audio_discard(channels, sample_rate, frames, ts.start, ts.end);
 
-//    /* ------------------------------------------------ */
-//    /* release audio sources */
-//    release_audio_sources(audio);
+    /* ------------------------------------------------ */
+    /* release audio sources */
+    d_ptr->render_order.reset();
 
     circlebuf_pop_front(&d_ptr->buffered_timestamps, NULL, sizeof(ts));
 
@@ -134,7 +217,8 @@ bool lite_obs_core_audio::audio_callback(void *param, uint64_t start_ts_in, uint
 
 bool lite_obs_core_audio::lite_obs_start_audio(const obs_audio_info *oai)
 {
-    if (d_ptr->audio && d_ptr->audio->audio_output_active())
+    auto audio = d_ptr->audio.load();
+    if (audio && audio->audio_output_active())
         return false;
 
     free_audio();
@@ -147,41 +231,70 @@ bool lite_obs_core_audio::lite_obs_start_audio(const obs_audio_info *oai)
     ai.samples_per_sec = oai->samples_per_sec;
     ai.format = audio_format::AUDIO_FORMAT_FLOAT_PLANAR;
     ai.speakers = oai->speakers;
+    ai.frames_per_block = oai->frames_per_block ? oai->frames_per_block : AUDIO_OUTPUT_FRAMES;
     ai.input_callback = lite_obs_core_audio::audio_callback;
     ai.input_param = this;
+    ai.input_clamped = true;
+
+    uint64_t block_ns = audio_frames_to_ns(ai.samples_per_sec, ai.frames_per_block);
+    d_ptr->max_buffering_ticks = (int)(MAX_BUFFERING_NS / block_ns);
+    if (d_ptr->max_buffering_ticks < 1)
+        d_ptr->max_buffering_ticks = 1;
 
     blog(LOG_INFO, "---------------------------------");
     blog(LOG_INFO,
          "audio settings reset:\n"
          "\tsamples per sec: %d\n"
-         "\tspeakers:        %d",
-         (int)ai.samples_per_sec, (int)ai.speakers);
-
-    auto audio = std::make_shared<audio_output>();
-    if (audio->audio_output_open(&ai) != AUDIO_OUTPUT_SUCCESS)
+         "\tspeakers:        %d\n"
+         "\tframes per tick: %d\n"
+         "\tmax buffering:   %d ticks",
+         (int)ai.samples_per_sec, (int)ai.speakers,
+         (int)ai.frames_per_block, d_ptr->max_buffering_ticks);
+
+    /* set before the open, the audio thread starts ticking in there.
+     * Stats readers load it atomically */
+    audio = std::make_shared<audio_output>();
+    d_ptr->audio.store(audio);
+    if (audio->audio_output_open(&ai) != AUDIO_OUTPUT_SUCCESS) {
+        d_ptr->audio.store(nullptr);
         return false;
+    }
 
-    d_ptr->audio = audio;
     return true;
 }
 
 void lite_obs_core_audio::lite_obs_stop_audio()
 {
-    if (d_ptr->audio) {
-        d_ptr->audio->audio_output_close();
-        d_ptr->audio.reset();
+    auto audio = d_ptr->audio.load();
+    if (audio) {
+        audio->audio_output_close();
+        d_ptr->audio.store(nullptr);
     }
 
     free_audio();
 }
 
+void lite_obs_core_audio::lite_obs_core_audio_get_stats(obs_stats *stats, bool reset)
+{
+    auto audio = d_ptr->audio.load();
+    if (audio)
+        audio->audio_output_get_tick_stats(&stats->audio_tick_jitter, &stats->audio_overruns, reset);
+
+    stats->audio_ticks = d_ptr->ticks;
+    stats->audio_buffering_ticks = (uint32_t)d_ptr->total_buffering_ticks;
+    stats->audio_buffering_wait_ticks = (uint32_t)d_ptr->buffering_wait_ticks;
+}
+
 void lite_obs_core_audio::free_audio()
 {
-    if (d_ptr->audio)
-        d_ptr->audio->audio_output_close();
+    auto audio = d_ptr->audio.load();
+    if (audio)
+        audio->audio_output_close();
 
     circlebuf_free(&d_ptr->buffered_timestamps);
     d_ptr->buffered_ts = 0;
     d_ptr->buffering_wait_ticks = 0;
     d_ptr->total_buffering_ticks = 0;
+    d_ptr->max_buffering_logged = false;
+    d_ptr->ticks = 0;
 }
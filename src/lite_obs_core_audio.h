@@ -1,8 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <stdint.h>
+#include <stddef.h>
 
 struct lite_obs_core_audio_private;
+struct ts_info;
 class audio_output;
 class lite_obs_core_audio
 {
@@ -15,6 +18,8 @@ public:
     bool lite_obs_start_audio(const struct obs_audio_info *oai);
     void lite_obs_stop_audio();
 
+    void lite_obs_core_audio_get_stats(struct obs_stats *stats, bool reset);
+
 private:
     bool audio_callback_internal(uint64_t start_ts_in, uint64_t end_ts_in,
                                  uint64_t *out_ts, uint32_t mixers,
@@ -23,6 +28,11 @@ private:
                                uint64_t *out_ts, uint32_t mixers,
                                struct audio_output_data *mixes);
 
+    void add_audio_buffering(size_t sample_rate, uint32_t frames,
+                             ts_info *ts, uint64_t min_ts);
+    void mix_audio(struct audio_output_data *mixes, uint32_t mixers, size_t channels,
+                   size_t sample_rate, uint32_t frames, const ts_info &ts);
+
 private:
     void free_audio();
 
@@ -1,5 +1,6 @@
 #include "lite_obs_core_video.h"
 #include "obs-defs.h"
+#include "lite_source.h"
 #include "graphics/gs_subsystem.h"
 #include "graphics/gs_texture.h"
 #include "graphics/gs_stagesurf.h"
@@ -8,13 +9,20 @@
 #include "media-io/video_output.h"
 #include "media-io/video-matrices.h"
 #include "util/log.h"
+#include "util/trace.h"
 #include "util/threading.h"
 #include "util/circlebuf.h"
+#include "util/stats.h"
+#include "util/atomic_shared_ptr.h"
 #include <glm/mat4x4.hpp>
 #include <glm/vec4.hpp>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <atomic>
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 
 struct obs_vframe_info {
     uint64_t timestamp{};
@@ -32,19 +40,39 @@ struct obs_graphics_context {
     bool was_active{};
 };
 
+/* canvas rectangle in pixels, x1/y1 exclusive */
+struct cull_rect {
+    float x0, y0, x1, y1;
+};
+
+/* more pieces than this left uncovered and the layer is simply drawn */
+#define MAX_CULL_PIECES 64
+
+/* a layer as drawn into the canvas, compared against the previous frame's
+ * layers to find what has to be redrawn */
+struct render_layer {
+    lite_source *source;
+    uint64_t serial;
+    cull_rect rect;
+};
+
 struct lite_obs_core_video_private
 {
     std::unique_ptr<graphics_subsystem> graphics{};
 
-    std::shared_ptr<gs_stagesurface> copy_surfaces[NUM_TEXTURES][NUM_CHANNELS]{};
+    std::shared_ptr<gs_stagesurface> copy_surfaces[MAX_NUM_TEXTURES][NUM_CHANNELS]{};
     std::shared_ptr<gs_texture> render_texture{};
     std::shared_ptr<gs_texture> output_texture{};
     std::shared_ptr<gs_texture> convert_textures[NUM_CHANNELS]{};
 
     bool texture_rendered{};
-    bool textures_copied[NUM_TEXTURES]{};
+    bool textures_copied[MAX_NUM_TEXTURES]{};
+    uint64_t textures_staged_ts[MAX_NUM_TEXTURES]{};
+    int num_textures = NUM_TEXTURES;
+    std::atomic_int pending_textures{};
     bool texture_converted{};
-    bool using_nv12_tex{};
+    bool using_packed_tex{};
+    bool using_mrt{};
     circlebuf vframe_info_buffer{};
     circlebuf vframe_info_buffer_gpu{};
 
@@ -56,14 +84,27 @@ struct lite_obs_core_video_private
 
     uint64_t video_time{};
     uint64_t video_frame_interval_ns{};
-    uint64_t video_avg_frame_time_ns{};
-    double video_fps{};
-    std::shared_ptr<video_output> video{};
+    std::atomic<uint64_t> video_avg_frame_time_ns{};
+    std::atomic<double> video_fps{};
+    atomic_shared_ptr<video_output> video{};
     std::thread video_thread{};
-    uint32_t total_frames{};
-    uint32_t lagged_frames{};
+    std::atomic<uint32_t> total_frames{};
+    std::atomic<uint32_t> lagged_frames{};
+    stats_histogram render_time{};
+    stats_histogram map_wait{};
+    stats_histogram pacer_jitter{};
+    stats_histogram readback_latency{};
+    std::atomic<uint32_t> readback_forced{};
     bool thread_initialized{};
 
+    /* composition state, graphics thread only.  last_layers is what the
+     * render texture currently holds, valid while canvas_valid is set */
+    std::vector<render_layer> render_layers{};
+    std::vector<render_layer> last_layers{};
+    bool canvas_valid{};
+    std::vector<cull_rect> occluders{};
+    std::vector<cull_rect> cull_pieces[2]{};
+
     bool gpu_conversion{};
     const char *conversion_techs[NUM_CHANNELS]{};
     bool conversion_needed{};
@@ -79,6 +120,19 @@ struct lite_obs_core_video_private
     std::atomic_long raw_active{};
     std::atomic_long gpu_encoder_active{};
 
+    /* the graphics thread waits here while nothing is active */
+    std::mutex idle_mutex;
+    std::condition_variable idle_cond;
+    uint64_t idle_interval_ns{};
+
+    std::atomic<uint64_t> context_switches{};
+
+    /* released at the top of the next frame by the graphics thread */
+    std::mutex deferred_mutex;
+    std::vector<std::shared_ptr<void>> deferred_free{};
+    bool deferred_open{};
+    std::atomic<uint32_t> gl_calls{};
+
     obs_video_info ovi{};
 };
 
@@ -94,16 +148,30 @@ lite_obs_core_video::~lite_obs_core_video()
 
 void lite_obs_core_video::lite_obs_core_video_change_raw_active(bool add)
 {
-    if (add)
+    if (add) {
         d_ptr->raw_active++;
-    else
+        wake_idle();
+    } else {
         d_ptr->raw_active--;
+    }
+}
+
+void lite_obs_core_video::wake_idle()
+{
+    /* taking the lock orders this against the graphics thread checking the
+     * wait condition, so the wakeup cannot fall in between */
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->idle_mutex);
+    }
+    d_ptr->idle_cond.notify_all();
 }
 
 void lite_obs_core_video::clear_base_frame_data(void)
 {
     d_ptr->texture_rendered = false;
     d_ptr->texture_converted = false;
+    memset(d_ptr->textures_copied, 0, sizeof(d_ptr->textures_copied));
+    d_ptr->pending_textures = 0;
     circlebuf_free(&d_ptr->vframe_info_buffer);
     d_ptr->cur_texture = 0;
 }
@@ -111,6 +179,7 @@ void lite_obs_core_video::clear_base_frame_data(void)
 void lite_obs_core_video::clear_raw_frame_data(void)
 {
     memset(d_ptr->textures_copied, 0, sizeof(d_ptr->textures_copied));
+    d_ptr->pending_textures = 0;
     circlebuf_free(&d_ptr->vframe_info_buffer);
 }
 
@@ -127,6 +196,7 @@ void lite_obs_core_video::video_sleep(bool raw_active, const bool gpu_active, ui
     int count;
 
     if (os_sleepto_ns(t)) {
+        d_ptr->pacer_jitter.record(os_gettime_ns() - t);
         *p_time = t;
         count = 1;
     } else {
@@ -147,35 +217,171 @@ void lite_obs_core_video::video_sleep(bool raw_active, const bool gpu_active, ui
         circlebuf_push_back(&d_ptr->vframe_info_buffer_gpu, &vframe_info, sizeof(vframe_info));
 }
 
-std::shared_ptr<gs_texture> test_texture;
-//#include <QFile>
-//#include <QImage>
-void lite_obs_core_video::render_all_sources()
+static inline bool cull_rect_empty(const cull_rect &rect)
 {
-    if (!test_texture) {
-//        QImage f(":/test.jpg");
-//        f = f.convertedTo(QImage::Format_RGBA8888);
-//        auto b = f.bits();
-//        test_texture = gs_texture_create(f.width(), f.height(), gs_color_format::GS_RGBA, 1, (const uint8_t **)&b, GS_DYNAMIC);
-//        blog(LOG_DEBUG, test_texture ? "111111111111 " : " 2222222222222222");
-        return;
+    return rect.x0 >= rect.x1 || rect.y0 >= rect.y1;
+}
+
+/* whether the occluders together cover all of rect: each occluder is cut out
+ * of what is left of rect, at most four pieces per cut */
+static bool cull_rect_covered(const cull_rect &rect, const std::vector<cull_rect> &occluders,
+                              std::vector<cull_rect> *pieces)
+{
+    auto *cur = &pieces[0];
+    auto *next = &pieces[1];
+
+    cur->assign(1, rect);
+    for (auto &o : occluders) {
+        next->clear();
+        for (auto &p : *cur) {
+            if (o.x0 >= p.x1 || o.x1 <= p.x0 || o.y0 >= p.y1 || o.y1 <= p.y0) {
+                next->push_back(p);
+                continue;
+            }
+
+            float y0 = std::max(p.y0, o.y0);
+            float y1 = std::min(p.y1, o.y1);
+            if (p.y0 < o.y0)
+                next->push_back({p.x0, p.y0, p.x1, o.y0});
+            if (p.y1 > o.y1)
+                next->push_back({p.x0, o.y1, p.x1, p.y1});
+            if (p.x0 < o.x0)
+                next->push_back({p.x0, y0, o.x0, y1});
+            if (p.x1 > o.x1)
+                next->push_back({o.x1, y0, p.x1, y1});
+        }
+
+        if (next->empty())
+            return true;
+        if (next->size() > MAX_CULL_PIECES)
+            return false;
+
+        std::swap(cur, next);
     }
 
-    auto program = d_ptr->graphics->gs_get_effect_by_name("Default_Draw");
-    gs_set_cur_effect(program);
+    return false;
+}
 
-    gs_technique_begin();
-    program->gs_effect_set_texture("image", test_texture);
-    d_ptr->graphics->gs_draw_sprite(test_texture, 0, test_texture->gs_texture_get_width(), test_texture->gs_texture_get_height());
-    gs_technique_end();
+static inline bool cull_rect_equal(const cull_rect &a, const cull_rect &b)
+{
+    return a.x0 == b.x0 && a.y0 == b.y0 && a.x1 == b.x1 && a.y1 == b.y1;
 }
 
-void lite_obs_core_video::render_main_texture()
+static inline void cull_rect_add(cull_rect *rect, const cull_rect &add)
+{
+    rect->x0 = std::min(rect->x0, add.x0);
+    rect->y0 = std::min(rect->y0, add.y0);
+    rect->x1 = std::max(rect->x1, add.x1);
+    rect->y1 = std::max(rect->y1, add.y1);
+}
+
+static inline bool cull_rect_intersects(const cull_rect &a, const cull_rect &b)
 {
+    return a.x0 < b.x1 && b.x0 < a.x1 && a.y0 < b.y1 && b.y0 < a.y1;
+}
+
+/* layers found in one list with the same serial and area are unchanged,
+ * everything else is damage, where the layer was as well as where it is */
+static void add_layer_damage(const std::vector<render_layer> &layers,
+                             const std::vector<render_layer> &other, cull_rect *damage)
+{
+    for (auto &layer : layers) {
+        bool found = false;
+        for (auto &o : other) {
+            if (o.source == layer.source && o.serial == layer.serial &&
+                    cull_rect_equal(o.rect, layer.rect)) {
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+            cull_rect_add(damage, layer.rect);
+    }
+}
+
+void lite_obs_core_video::render_all_sources()
+{
+    auto sources = obs.sources();
+    const float canvas_cx = (float)d_ptr->base_width;
+    const float canvas_cy = (float)d_ptr->base_height;
+
+    d_ptr->render_layers.clear();
+    d_ptr->occluders.clear();
+
+    /* walk the layers front to back, a layer that is off the canvas or under
+     * opaque layers above it is neither ticked nor drawn.  The area a layer
+     * may draw to is rounded out to whole pixels and opaque areas are
+     * rounded in, partially covered edge pixels still blend */
+    for (size_t i = sources->size(); i > 0; i--) {
+        auto &source = (*sources)[i - 1];
+        glm::vec2 min, max;
+
+        if (!source->is_async_video_source() || !source->visible())
+            continue;
+
+        cull_rect rect = {0.0f, 0.0f, canvas_cx, canvas_cy};
+        if (source->video_bounds(&min, &max)) {
+            rect = {std::max(floorf(min.x), 0.0f), std::max(floorf(min.y), 0.0f),
+                    std::min(ceilf(max.x), canvas_cx), std::min(ceilf(max.y), canvas_cy)};
+            if (cull_rect_empty(rect) ||
+                    cull_rect_covered(rect, d_ptr->occluders, d_ptr->cull_pieces))
+                continue;
+        }
+
+        source->async_video_tick(d_ptr->video_time);
+        d_ptr->render_layers.push_back({source.get(), source->video_serial(), rect});
+
+        if (source->video_opaque_bounds(&min, &max)) {
+            cull_rect opaque = {std::max(ceilf(min.x), 0.0f), std::max(ceilf(min.y), 0.0f),
+                                std::min(floorf(max.x), canvas_cx), std::min(floorf(max.y), canvas_cy)};
+            if (!cull_rect_empty(opaque))
+                d_ptr->occluders.push_back(opaque);
+        }
+    }
+
+    /* only the bounding box of what changed since the last frame is cleared
+     * and redrawn, the rest of the render texture is kept as is */
+    cull_rect damage = {canvas_cx, canvas_cy, 0.0f, 0.0f};
+    if (d_ptr->canvas_valid) {
+        add_layer_damage(d_ptr->render_layers, d_ptr->last_layers, &damage);
+        add_layer_damage(d_ptr->last_layers, d_ptr->render_layers, &damage);
+    } else {
+        damage = {0.0f, 0.0f, canvas_cx, canvas_cy};
+    }
+
+    d_ptr->last_layers.swap(d_ptr->render_layers);
+    d_ptr->canvas_valid = true;
+
+    if (cull_rect_empty(damage))
+        return;
+
+    gs_rect scissor = {(int)damage.x0, (int)damage.y0,
+                       (int)(damage.x1 - damage.x0), (int)(damage.y1 - damage.y0)};
+    bool full = scissor.cx == (int)d_ptr->base_width && scissor.cy == (int)d_ptr->base_height;
+    if (!full)
+        gs_set_scissor_rect(&scissor);
+
     glm::vec4 clear_color(0);
-    gs_set_render_target(d_ptr->render_texture, NULL);
     gs_clear(GS_CLEAR_COLOR, &clear_color, 1.0f, 0);
 
+    /* every frame is converted before the batch is opened, the conversion
+     * draws would clobber the batch's program and buffers otherwise */
+    d_ptr->graphics->gs_sprite_batch_begin();
+    for (auto it = d_ptr->last_layers.rbegin(); it != d_ptr->last_layers.rend(); ++it) {
+        if (cull_rect_intersects(it->rect, damage))
+            it->source->video_render(d_ptr->graphics.get());
+    }
+    d_ptr->graphics->gs_sprite_batch_end();
+
+    if (!full)
+        gs_set_scissor_rect(nullptr);
+}
+
+void lite_obs_core_video::render_main_texture()
+{
+    TRACE_SCOPE("render_main_texture");
+    gs_set_render_target(d_ptr->render_texture, NULL);
     gs_set_render_size(d_ptr->base_width, d_ptr->base_height);
 
     render_all_sources();
@@ -202,6 +408,7 @@ std::shared_ptr<gs_program> lite_obs_core_video::get_scale_effect(uint32_t width
 
 std::shared_ptr<gs_texture> lite_obs_core_video::render_output_texture()
 {
+    TRACE_SCOPE("render_output_texture");
     //here we remove RGBA output format support.
     auto texture = d_ptr->render_texture;
     auto target = d_ptr->output_texture;
@@ -217,13 +424,13 @@ std::shared_ptr<gs_texture> lite_obs_core_video::render_output_texture()
     gs_set_render_size(width, height);
 
     glm::vec2 base = {(float)d_ptr->base_width, (float)d_ptr->base_height};
-    program->gs_effect_set_param("base_dimension", base);
-    program->gs_effect_set_param("base_dimension_f", base);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_BASE_DIMENSION, base);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_BASE_DIMENSION_F, base);
 
     glm::vec2 base_i = {1.0f / (float)d_ptr->base_width, 1.0f / (float)d_ptr->base_height};
-    program->gs_effect_set_param("base_dimension_i", base_i);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_BASE_DIMENSION_I, base_i);
 
-    program->gs_effect_set_texture("image", texture);
+    program->gs_effect_set_texture(gs_effect_param_id::GS_PARAM_IMAGE, texture);
 
     gs_set_cur_effect(program);
 
@@ -239,10 +446,15 @@ std::shared_ptr<gs_texture> lite_obs_core_video::render_output_texture()
 
 void lite_obs_core_video::render_convert_plane(std::shared_ptr<gs_texture> target)
 {
-    const uint32_t width = target->gs_texture_get_width();
-    const uint32_t height = target->gs_texture_get_height();
+    render_convert_planes(&target, 1);
+}
 
-    gs_set_render_target(target, NULL);
+void lite_obs_core_video::render_convert_planes(const std::shared_ptr<gs_texture> *targets, uint32_t count)
+{
+    const uint32_t width = targets[0]->gs_texture_get_width();
+    const uint32_t height = targets[0]->gs_texture_get_height();
+
+    gs_set_render_targets(targets, count, NULL);
     gs_set_render_size(width, height);
 
     gs_technique_begin();
@@ -252,70 +464,67 @@ void lite_obs_core_video::render_convert_plane(std::shared_ptr<gs_texture> targe
 
 void lite_obs_core_video::render_convert_texture(std::shared_ptr<gs_texture> texture)
 {
+    TRACE_SCOPE("render_convert_texture");
     gs_enable_blending(false);
 
     glm::vec4 vec0 = {d_ptr->color_matrix[4], d_ptr->color_matrix[5], d_ptr->color_matrix[6], d_ptr->color_matrix[7]};
     glm::vec4 vec1 = {d_ptr->color_matrix[0], d_ptr->color_matrix[1], d_ptr->color_matrix[2], d_ptr->color_matrix[3]};
     glm::vec4 vec2 = {d_ptr->color_matrix[8], d_ptr->color_matrix[9], d_ptr->color_matrix[10], d_ptr->color_matrix[11]};
 
-    if (d_ptr->convert_textures[0]) {
+    if (d_ptr->using_packed_tex || d_ptr->using_mrt) {
+        /* one draw writes every plane, either into the packed texture or
+         * into all plane textures bound as render targets */
         auto program = d_ptr->graphics->gs_get_effect_by_name(d_ptr->conversion_techs[0]);
+        int width = (int)d_ptr->output_width;
+        int height = (int)d_ptr->output_height;
+
         gs_set_cur_effect(program);
-        program->gs_effect_set_param("color_vec0", vec0);
-        program->gs_effect_set_texture("image", texture);
+        program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC0, vec0);
+        program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC1, vec1);
+        program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC2, vec2);
+        program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_WIDTH, &width, sizeof(width));
+        program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_HEIGHT, &height, sizeof(height));
+        program->gs_effect_set_texture(gs_effect_param_id::GS_PARAM_IMAGE, texture);
+
+        uint32_t count = 1;
+        while (!d_ptr->using_packed_tex && count < NUM_CHANNELS && d_ptr->convert_textures[count])
+            count++;
+        render_convert_planes(d_ptr->convert_textures, count);
+    } else if (d_ptr->convert_textures[0]) {
+        auto program = d_ptr->graphics->gs_get_effect_by_name(d_ptr->conversion_techs[0]);
+        gs_set_cur_effect(program);
+        program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC0, vec0);
+        program->gs_effect_set_texture(gs_effect_param_id::GS_PARAM_IMAGE, texture);
         render_convert_plane(d_ptr->convert_textures[0]);
 
         if (d_ptr->convert_textures[1]) {
             auto program1 = d_ptr->graphics->gs_get_effect_by_name(d_ptr->conversion_techs[1]);
             gs_set_cur_effect(program1);
-            program1->gs_effect_set_param("color_vec1", vec1);
-            program1->gs_effect_set_texture("image", texture);
+            program1->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC1, vec1);
+            program1->gs_effect_set_texture(gs_effect_param_id::GS_PARAM_IMAGE, texture);
             if (!d_ptr->convert_textures[2])
-                program1->gs_effect_set_param("color_vec2", vec2);
-            program1->gs_effect_set_param("width_i", d_ptr->conversion_width_i);
+                program1->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC2, vec2);
+            program1->gs_effect_set_param(gs_effect_param_id::GS_PARAM_WIDTH_I, d_ptr->conversion_width_i);
             render_convert_plane(d_ptr->convert_textures[1]);
 
             if (d_ptr->convert_textures[2]) {
                 auto program2 = d_ptr->graphics->gs_get_effect_by_name(d_ptr->conversion_techs[2]);
                 gs_set_cur_effect(program2);
-                program2->gs_effect_set_param("color_vec1", vec1);
-                program2->gs_effect_set_texture("image", texture);
-                program2->gs_effect_set_param("color_vec2", vec2);
-                program2->gs_effect_set_param("width_i", d_ptr->conversion_width_i);
+                program2->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC1, vec1);
+                program2->gs_effect_set_texture(gs_effect_param_id::GS_PARAM_IMAGE, texture);
+                program2->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC2, vec2);
+                program2->gs_effect_set_param(gs_effect_param_id::GS_PARAM_WIDTH_I, d_ptr->conversion_width_i);
                 render_convert_plane(d_ptr->convert_textures[2]);
             }
         }
     }
 
-    for (int i = 0; i < 3; ++i) {
-        if (!d_ptr->convert_textures[i])
-            continue;
-
-        glm::vec4 vec0 = {d_ptr->color_matrix[4], d_ptr->color_matrix[5], d_ptr->color_matrix[6], d_ptr->color_matrix[7]};
-        glm::vec4 vec1 = {d_ptr->color_matrix[0], d_ptr->color_matrix[1], d_ptr->color_matrix[2], d_ptr->color_matrix[3]};
-        glm::vec4 vec2 = {d_ptr->color_matrix[8], d_ptr->color_matrix[9], d_ptr->color_matrix[10], d_ptr->color_matrix[11]};
-
-        auto program = d_ptr->graphics->gs_get_effect_by_name(d_ptr->conversion_techs[i]);
-        program->gs_effect_set_texture("image", texture);
-        if (i == 0) {
-            program->gs_effect_set_param("color_vec0", vec0);
-        } else if (i == 1) {
-            program->gs_effect_set_param("color_vec1", vec1);
-            if (!d_ptr->convert_textures[i+1])
-                program->gs_effect_set_param("color_vec2", vec2);
-            program->gs_effect_set_param("width_i", d_ptr->conversion_width_i);
-        } else if (i == 2) {
-            program->gs_effect_set_param("color_vec2", vec2);
-            program->gs_effect_set_param("width_i", d_ptr->conversion_width_i);
-        }
-    }
-
     gs_enable_blending(true);
 
     d_ptr->texture_converted = true;
 }
 
-void lite_obs_core_video::stage_output_texture(int cur_texture)
+void lite_obs_core_video::unmap_output_surfaces()
 {
     for (int c = 0; c < NUM_CHANNELS; ++c) {
         auto surface = d_ptr->mapped_surfaces[c].lock();
@@ -324,25 +533,37 @@ void lite_obs_core_video::stage_output_texture(int cur_texture)
             d_ptr->mapped_surfaces[c].reset();
         }
     }
+}
+
+void lite_obs_core_video::stage_output_texture(int cur_texture)
+{
+    TRACE_SCOPE("stage_output_texture");
+    unmap_output_surfaces();
 
     if (!d_ptr->gpu_conversion) {
         auto copy = d_ptr->copy_surfaces[cur_texture][0];
         if (copy)
             copy->gs_stagesurface_stage_texture(d_ptr->output_texture);
-
-        d_ptr->textures_copied[cur_texture] = true;
     } else if (d_ptr->texture_converted) {
         for (int i = 0; i < NUM_CHANNELS; i++) {
             auto copy = d_ptr->copy_surfaces[cur_texture][i];
             if (copy)
                 copy->gs_stagesurface_stage_texture(d_ptr->convert_textures[i]);
         }
-
-        d_ptr->textures_copied[cur_texture] = true;
+    } else {
+        return;
     }
+
+    /* staged slots stay in order, cur_texture only moves on once used */
+    d_ptr->textures_copied[cur_texture] = true;
+    d_ptr->textures_staged_ts[cur_texture] = os_gettime_ns();
+    d_ptr->pending_textures++;
+
+    if (++d_ptr->cur_texture == d_ptr->num_textures)
+        d_ptr->cur_texture = 0;
 }
 
-void lite_obs_core_video::render_video(bool raw_active, const bool gpu_active, int cur_texture, int prev_texture)
+void lite_obs_core_video::render_video(bool raw_active, const bool gpu_active, int cur_texture)
 {
     gs_begin_scene();
 
@@ -379,24 +600,68 @@ void lite_obs_core_video::render_video(bool raw_active, const bool gpu_active, i
     gs_end_scene();
 }
 
-bool lite_obs_core_video::download_frame(int prev_texture, video_data *frame)
+bool lite_obs_core_video::texture_ready(int texture)
 {
-    if (!d_ptr->textures_copied[prev_texture])
+    for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
+        auto surface = d_ptr->copy_surfaces[texture][channel];
+        if (surface && !surface->gs_stagesurface_ready())
+            return false;
+    }
+
+    return true;
+}
+
+bool lite_obs_core_video::download_frame(int queued, video_data *frame)
+{
+    TRACE_SCOPE("download_frame");
+    /* the slot staged this tick gets its vframe info in video_sleep, so
+     * only slots staged on earlier ticks (queued) can be handed out */
+    if (!queued)
         return false;
 
+    const int num_textures = d_ptr->num_textures;
+    const int oldest = (d_ptr->cur_texture - d_ptr->pending_textures + num_textures) % num_textures;
+
+    /* only a full ring forces a map that may stall on the gpu, otherwise
+     * the frame stays queued until its fence has signaled */
+    if (d_ptr->pending_textures < num_textures) {
+        if (!texture_ready(oldest))
+            return false;
+    } else {
+        d_ptr->readback_forced++;
+    }
+
+    d_ptr->textures_copied[oldest] = false;
+    d_ptr->pending_textures--;
+
+    uint64_t map_start = os_gettime_ns();
+    bool success = true;
+
     for (int channel = 0; channel < NUM_CHANNELS; ++channel) {
-        auto surface = d_ptr->copy_surfaces[prev_texture][channel];
+        auto surface = d_ptr->copy_surfaces[oldest][channel];
         if (surface) {
-            if (!surface->gs_stagesurface_map(&frame->frame.data[channel], &frame->frame.linesize[channel]))
-                return false;
+            if (!surface->gs_stagesurface_map(&frame->frame.data[channel], &frame->frame.linesize[channel])) {
+                success = false;
+                break;
+            }
 
             d_ptr->mapped_surfaces[channel] = surface;
         }
     }
-    return true;
+
+    uint64_t map_end = os_gettime_ns();
+    d_ptr->map_wait.record(map_end - map_start);
+    d_ptr->readback_latency.record(map_end - d_ptr->textures_staged_ts[oldest]);
+
+    /* the slot is dropped, so is its frame info, otherwise every later
+     * frame would go out with the timing of the one before it */
+    if (!success)
+        circlebuf_pop_front(&d_ptr->vframe_info_buffer, NULL, sizeof(obs_vframe_info));
+
+    return success;
 }
 
-static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
+const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
                                               uint32_t linesize_input,
                                               uint32_t linesize_output,
                                               const uint8_t *in, uint8_t *out)
@@ -416,22 +681,42 @@ static const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
     return in;
 }
 
-void lite_obs_core_video::set_gpu_converted_data_internal(bool using_nv12_tex, video_frame *output, const struct video_data *input, video_format format, uint32_t width, uint32_t height)
+void lite_obs_core_video::set_gpu_converted_data_internal(bool using_packed_tex, bool using_mrt, video_frame *output, const struct video_data *input, video_format format, uint32_t width, uint32_t height)
 {
-    if (using_nv12_tex) {
-        const uint8_t *const in_uv = set_gpu_converted_plane(
-                    width, height, input->frame.linesize[0], output->linesize[0],
-                input->frame.data[0], output->data[0]);
+    if (using_packed_tex) {
+        /* the planes follow each other in the single readback, chroma
+         * planes of I420 are packed without row padding */
+        const uint8_t *in = input->frame.data[0];
+        const uint32_t linesize = input->frame.linesize[0];
 
-        const uint32_t height_d2 = height / 2;
-        set_gpu_converted_plane(width, height_d2, input->frame.linesize[0],
-                output->linesize[1], in_uv,
-                output->data[1]);
+        switch (format) {
+        case video_format::VIDEO_FORMAT_NV12:
+            in = set_gpu_converted_plane(width, height, linesize, output->linesize[0], in, output->data[0]);
+            set_gpu_converted_plane(width, height / 2, linesize, output->linesize[1], in, output->data[1]);
+            break;
+        case video_format::VIDEO_FORMAT_I420:
+            in = set_gpu_converted_plane(width, height, linesize, output->linesize[0], in, output->data[0]);
+            in = set_gpu_converted_plane(width / 2, height / 2, width / 2, output->linesize[1], in, output->data[1]);
+            set_gpu_converted_plane(width / 2, height / 2, width / 2, output->linesize[2], in, output->data[2]);
+            break;
+        case video_format::VIDEO_FORMAT_I444:
+            in = set_gpu_converted_plane(width, height, linesize, output->linesize[0], in, output->data[0]);
+            in = set_gpu_converted_plane(width, height, linesize, output->linesize[1], in, output->data[1]);
+            set_gpu_converted_plane(width, height, linesize, output->linesize[2], in, output->data[2]);
+            break;
+        default:
+            break;
+        }
     } else {
+        /* the rgba luma target of the mrt pass holds two rows per texel
+         * row, it reads back as a regular plane with half the linesize */
+        const uint32_t luma_linesize = using_mrt && format != video_format::VIDEO_FORMAT_I444 ?
+                    input->frame.linesize[0] / 2 : input->frame.linesize[0];
+
         switch (format) {
         case video_format::VIDEO_FORMAT_I420: {
             set_gpu_converted_plane(width, height,
-                                    input->frame.linesize[0],
+                                    luma_linesize,
                     output->linesize[0],
                     input->frame.data[0],
                     output->data[0]);
@@ -455,7 +740,7 @@ void lite_obs_core_video::set_gpu_converted_data_internal(bool using_nv12_tex, v
         }
         case video_format::VIDEO_FORMAT_NV12: {
             set_gpu_converted_plane(width, height,
-                                    input->frame.linesize[0],
+                                    luma_linesize,
                     output->linesize[0],
                     input->frame.data[0],
                     output->data[0]);
@@ -471,7 +756,7 @@ void lite_obs_core_video::set_gpu_converted_data_internal(bool using_nv12_tex, v
         }
         case video_format::VIDEO_FORMAT_I444: {
             set_gpu_converted_plane(width, height,
-                                    input->frame.linesize[0],
+                                    luma_linesize,
                     output->linesize[0],
                     input->frame.data[0],
                     output->data[0]);
@@ -515,19 +800,21 @@ void lite_obs_core_video::set_gpu_converted_data(video_frame *output,
                                                  const struct video_data *input,
                                                  const struct video_output_info *info)
 {
-    set_gpu_converted_data_internal(false, output, input,
+    set_gpu_converted_data_internal(d_ptr->using_packed_tex, d_ptr->using_mrt, output, input,
                                     info->format, info->width,
                                     info->height);
 }
 
 void lite_obs_core_video::output_video_data(video_data *input_frame, int count)
 {
-    video_frame output_frame;
+    TRACE_SCOPE("output_video_data");
+    video_frame output_frame{};
     bool locked;
 
-    const auto info = d_ptr->video->video_output_get_info();
+    auto video = d_ptr->video.load();
+    const auto info = video->video_output_get_info();
 
-    locked = d_ptr->video->video_output_lock_frame(&output_frame, count, input_frame->timestamp);
+    locked = video->video_output_lock_frame(&output_frame, count, input_frame->timestamp);
     if (locked) {
         if (d_ptr->gpu_conversion) {
             set_gpu_converted_data(&output_frame, input_frame, info);
@@ -536,45 +823,101 @@ void lite_obs_core_video::output_video_data(video_data *input_frame, int count)
             //copy_rgbx_frame(&output_frame, input_frame, info);
         }
 
-        d_ptr->video->video_output_unlock_frame();
+        video->video_output_unlock_frame();
     }
 }
 
 void lite_obs_core_video::output_frame(bool raw_active, const bool gpu_active)
 {
-    int cur_texture = d_ptr->cur_texture;
-    int prev_texture = cur_texture == 0 ? NUM_TEXTURES - 1 : cur_texture - 1;
-
+    int queued = d_ptr->pending_textures;
     video_data frame;
     bool frame_ready = 0;
 
-    gs_enter_contex(d_ptr->graphics);
-
-    render_video(raw_active, gpu_active, cur_texture, prev_texture);
+    render_video(raw_active, gpu_active, d_ptr->cur_texture);
 
     if (raw_active) {
-        frame_ready = download_frame(prev_texture, &frame);
+        frame_ready = download_frame(queued, &frame);
     }
 
     gs_flush();
 
-    gs_leave_context();
-
-    if (raw_active && frame_ready) {
+    while (raw_active && frame_ready) {
         struct obs_vframe_info vframe_info;
         circlebuf_pop_front(&d_ptr->vframe_info_buffer, &vframe_info, sizeof(vframe_info));
 
         frame.timestamp = vframe_info.timestamp;
         output_video_data(&frame, vframe_info.count);
+
+        /* the gpu has caught up if the next queued slot signaled as well,
+         * drain it now so one late fence does not keep every later frame
+         * a tick behind for the rest of the session */
+        if (--queued == 0)
+            break;
+
+        unmap_output_surfaces();
+        frame_ready = download_frame(queued, &frame);
     }
+}
 
-    if (++d_ptr->cur_texture == NUM_TEXTURES)
-        d_ptr->cur_texture = 0;
+void lite_obs_core_video::video_idle(obs_graphics_context *context)
+{
+    const uint64_t idle_interval = d_ptr->idle_interval_ns;
+
+    if (idle_interval)
+        output_frame(false, false);
+
+    /* other threads may need the context while this one waits */
+    gs_leave_context();
+    {
+        std::unique_lock<std::mutex> lock(d_ptr->idle_mutex);
+        auto video = d_ptr->video.load();
+        auto wake = [this, &video] {
+            return lite_obs_video_active() || video->video_output_stopped();
+        };
+
+        if (idle_interval)
+            d_ptr->idle_cond.wait_for(lock, std::chrono::nanoseconds(idle_interval), wake);
+        else
+            d_ptr->idle_cond.wait(lock, wake);
+    }
+    gs_enter_contex(d_ptr->graphics);
+
+    /* continue on the same frame grid, the time spent idle is neither
+     * counted as lagged frames nor repeated to the outputs */
+    uint64_t now = os_gettime_ns();
+    if (now > d_ptr->video_time)
+        d_ptr->video_time += (now - d_ptr->video_time) / context->interval * context->interval;
+
+    context->last_time = d_ptr->video_time;
+    context->frame_time_total_ns = 0;
+    context->fps_total_ns = 0;
+    context->fps_total_frames = 0;
+}
+
+bool lite_obs_core_video::defer_graphics_free(std::shared_ptr<void> obj)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->deferred_mutex);
+    if (!d_ptr->deferred_open)
+        return false;
+
+    d_ptr->deferred_free.push_back(std::move(obj));
+    return true;
+}
+
+void lite_obs_core_video::free_deferred_graphics()
+{
+    std::vector<std::shared_ptr<void>> objs;
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->deferred_mutex);
+        objs.swap(d_ptr->deferred_free);
+    }
 }
 
 bool lite_obs_core_video::graphics_loop(obs_graphics_context *context)
 {
-    const bool stop_requested = d_ptr->video->video_output_stopped();
+    const bool stop_requested = d_ptr->video.load()->video_output_stopped();
+
+    free_deferred_graphics();
 
     uint64_t frame_start = os_gettime_ns();
     uint64_t frame_time_ns;
@@ -582,6 +925,14 @@ bool lite_obs_core_video::graphics_loop(obs_graphics_context *context)
     const bool gpu_active = d_ptr->gpu_encoder_active > 0;
     const bool active = raw_active || gpu_active;
 
+    if (!active) {
+        context->gpu_was_active = false;
+        context->raw_was_active = false;
+        context->was_active = false;
+        video_idle(context);
+        return !stop_requested;
+    }
+
     if (!context->was_active && active)
         clear_base_frame_data();
     if (!context->raw_was_active && raw_active)
@@ -593,15 +944,23 @@ bool lite_obs_core_video::graphics_loop(obs_graphics_context *context)
     context->raw_was_active = raw_active;
     context->was_active = active;
 
+    uint64_t gl_calls = gs_gl_calls();
     output_frame(raw_active, gpu_active);
+    d_ptr->gl_calls = (uint32_t)(gs_gl_calls() - gl_calls);
 
     frame_time_ns = os_gettime_ns() - frame_start;
+    d_ptr->render_time.record(frame_time_ns);
+
+    /* threads waiting for the context get it while this one sleeps */
+    gs_yield_context();
+    d_ptr->context_switches = gs_context_switches();
 
     video_sleep(raw_active, gpu_active, &d_ptr->video_time, context->interval);
 
     context->frame_time_total_ns += frame_time_ns;
     context->fps_total_ns += (d_ptr->video_time - context->last_time);
     context->fps_total_frames++;
+    context->last_time = d_ptr->video_time;
 
     if (context->fps_total_ns >= 1000000000ULL) {
         d_ptr->video_fps = (double)context->fps_total_frames / ((double)context->fps_total_ns / 1000000000.0);
@@ -617,7 +976,7 @@ bool lite_obs_core_video::graphics_loop(obs_graphics_context *context)
 
 void lite_obs_core_video::graphics_task_func()
 {
-    const uint64_t interval = d_ptr->video->video_output_get_frame_time();
+    const uint64_t interval = d_ptr->video.load()->video_output_get_frame_time();
 
     d_ptr->video_time = os_gettime_ns();
     d_ptr->video_frame_interval_ns = interval;
@@ -629,7 +988,7 @@ void lite_obs_core_video::graphics_task_func()
     context.frame_time_total_ns = 0;
     context.fps_total_ns = 0;
     context.fps_total_frames = 0;
-    context.last_time = 0;
+    context.last_time = d_ptr->video_time;
     context.gpu_was_active = false;
     context.raw_was_active = false;
     context.was_active = false;
@@ -653,6 +1012,30 @@ uint32_t lite_obs_core_video::lagged_frames()
     return d_ptr->lagged_frames;
 }
 
+void lite_obs_core_video::lite_obs_core_video_get_stats(obs_stats *stats, bool reset)
+{
+    stats->video_fps = d_ptr->video_fps;
+    stats->video_avg_frame_time_ns = d_ptr->video_avg_frame_time_ns;
+    stats->total_frames = d_ptr->total_frames;
+    stats->lagged_frames = d_ptr->lagged_frames;
+    d_ptr->render_time.snapshot(&stats->render_time, reset);
+    d_ptr->map_wait.snapshot(&stats->map_wait, reset);
+    d_ptr->pacer_jitter.snapshot(&stats->pacer_jitter, reset);
+    d_ptr->readback_latency.snapshot(&stats->readback_latency, reset);
+    stats->readback_queued = (uint32_t)d_ptr->pending_textures;
+    stats->readback_forced = d_ptr->readback_forced;
+    stats->graphics_context_switches = d_ptr->context_switches;
+    stats->gl_calls = d_ptr->gl_calls;
+
+    auto video = d_ptr->video.load();
+    if (video) {
+        stats->video_output_frames = video->video_output_get_total_frames();
+        stats->skipped_frames = video->video_output_get_skipped_frames();
+        stats->video_cache_frames = video->video_output_get_cached_frames();
+        stats->video_cache_size = (uint32_t)video->video_output_get_info()->cache_size;
+    }
+}
+
 void lite_obs_core_video::set_video_matrix(obs_video_info *ovi)
 {
     glm::mat4x4 mat{0};
@@ -674,6 +1057,27 @@ void lite_obs_core_video::set_video_matrix(obs_video_info *ovi)
     memcpy(d_ptr->color_matrix, &mat, sizeof(float) * 16);
 }
 
+static inline uint32_t packed_texture_height(video_format format, uint32_t height)
+{
+    return format == video_format::VIDEO_FORMAT_I444 ? height * 3 : height * 3 / 2;
+}
+
+/* the conversion targets store four pixels of a row per rgba texel, for
+ * the subsampled formats all mrt attachments are drawn at chroma
+ * resolution.  reset already aligns the output size, anything else takes
+ * one pass per plane */
+static inline bool mrt_conversion_supported(video_format format, uint32_t width, uint32_t height)
+{
+    switch (format) {
+    case video_format::VIDEO_FORMAT_I420:
+    case video_format::VIDEO_FORMAT_NV12:
+    case video_format::VIDEO_FORMAT_I444:
+        return (width % 4) == 0 && (height % 2) == 0;
+    default:
+        return false;
+    }
+}
+
 void lite_obs_core_video::calc_gpu_conversion_sizes()
 {
     d_ptr->conversion_needed = false;
@@ -682,6 +1086,44 @@ void lite_obs_core_video::calc_gpu_conversion_sizes()
     d_ptr->conversion_techs[2] = NULL;
     d_ptr->conversion_width_i = 0.f;
 
+    if (d_ptr->using_packed_tex) {
+        switch (d_ptr->output_format) {
+        case video_format::VIDEO_FORMAT_I420:
+            d_ptr->conversion_techs[0] = "Convert_Packed_I420";
+            break;
+        case video_format::VIDEO_FORMAT_NV12:
+            d_ptr->conversion_techs[0] = "Convert_Packed_NV12";
+            break;
+        case video_format::VIDEO_FORMAT_I444:
+            d_ptr->conversion_techs[0] = "Convert_Packed_I444";
+            break;
+        default:
+            break;
+        }
+
+        d_ptr->conversion_needed = d_ptr->conversion_techs[0] != NULL;
+        return;
+    }
+
+    if (d_ptr->using_mrt) {
+        switch (d_ptr->output_format) {
+        case video_format::VIDEO_FORMAT_I420:
+            d_ptr->conversion_techs[0] = "Convert_MRT_I420";
+            break;
+        case video_format::VIDEO_FORMAT_NV12:
+            d_ptr->conversion_techs[0] = "Convert_MRT_NV12";
+            break;
+        case video_format::VIDEO_FORMAT_I444:
+            d_ptr->conversion_techs[0] = "Convert_MRT_I444";
+            break;
+        default:
+            break;
+        }
+
+        d_ptr->conversion_needed = d_ptr->conversion_techs[0] != NULL;
+        return;
+    }
+
     switch (d_ptr->output_format) {
     case video_format::VIDEO_FORMAT_I420:
         d_ptr->conversion_needed = true;
@@ -718,7 +1160,24 @@ bool lite_obs_core_video::init_gpu_conversion()
 {
     calc_gpu_conversion_sizes();
 
-    d_ptr->convert_textures[0] = gs_texture_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8, 1, NULL, GS_RENDER_TARGET);
+    if (d_ptr->using_packed_tex) {
+        d_ptr->convert_textures[0] = gs_texture_create(d_ptr->output_width / 4, packed_texture_height(d_ptr->output_format, d_ptr->output_height), gs_color_format::GS_RGBA, 1, NULL, GS_RENDER_TARGET);
+        return d_ptr->convert_textures[0] != nullptr;
+    }
+
+    if (d_ptr->using_mrt && d_ptr->output_format == video_format::VIDEO_FORMAT_I444) {
+        for (int c = 0; c < 3; c++) {
+            d_ptr->convert_textures[c] = gs_texture_create(d_ptr->output_width / 4, d_ptr->output_height, gs_color_format::GS_RGBA, 1, NULL, GS_RENDER_TARGET);
+            if (!d_ptr->convert_textures[c])
+                return false;
+        }
+        return true;
+    }
+
+    if (d_ptr->using_mrt)
+        d_ptr->convert_textures[0] = gs_texture_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_RGBA, 1, NULL, GS_RENDER_TARGET);
+    else
+        d_ptr->convert_textures[0] = gs_texture_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8, 1, NULL, GS_RENDER_TARGET);
 
     switch (d_ptr->output_format) {
     case video_format::VIDEO_FORMAT_I420:
@@ -750,7 +1209,7 @@ bool lite_obs_core_video::init_gpu_conversion()
 
 void lite_obs_core_video::clear_gpu_copy_surface()
 {
-    for (size_t i = 0; i < NUM_TEXTURES; i++) {
+    for (size_t i = 0; i < MAX_NUM_TEXTURES; i++) {
         for (size_t c = 0; c < NUM_CHANNELS; c++) {
             if (d_ptr->copy_surfaces[i][c]) {
                 d_ptr->copy_surfaces[i][c].reset();
@@ -761,7 +1220,24 @@ void lite_obs_core_video::clear_gpu_copy_surface()
 
 bool lite_obs_core_video::init_gpu_copy_surface(size_t i)
 {
-    d_ptr->copy_surfaces[i][0] = gs_stagesurface_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8);
+    if (d_ptr->using_packed_tex) {
+        d_ptr->copy_surfaces[i][0] = gs_stagesurface_create(d_ptr->output_width / 4, packed_texture_height(d_ptr->output_format, d_ptr->output_height), gs_color_format::GS_RGBA);
+        return d_ptr->copy_surfaces[i][0] != nullptr;
+    }
+
+    if (d_ptr->using_mrt && d_ptr->output_format == video_format::VIDEO_FORMAT_I444) {
+        for (int c = 0; c < 3; c++) {
+            d_ptr->copy_surfaces[i][c] = gs_stagesurface_create(d_ptr->output_width / 4, d_ptr->output_height, gs_color_format::GS_RGBA);
+            if (!d_ptr->copy_surfaces[i][c])
+                return false;
+        }
+        return true;
+    }
+
+    if (d_ptr->using_mrt)
+        d_ptr->copy_surfaces[i][0] = gs_stagesurface_create(d_ptr->output_width / 2, d_ptr->output_height / 2, gs_color_format::GS_RGBA);
+    else
+        d_ptr->copy_surfaces[i][0] = gs_stagesurface_create(d_ptr->output_width, d_ptr->output_height, gs_color_format::GS_R8);
     if (!d_ptr->copy_surfaces[i][0])
         return false;
 
@@ -796,7 +1272,7 @@ bool lite_obs_core_video::init_gpu_copy_surface(size_t i)
 
 bool lite_obs_core_video::init_textures()
 {
-    for (size_t i = 0; i < NUM_TEXTURES; i++) {
+    for (int i = 0; i < d_ptr->num_textures; i++) {
         if (d_ptr->gpu_conversion) {
             if (!init_gpu_copy_surface(i)) {
                 clear_gpu_copy_surface();
@@ -811,6 +1287,8 @@ bool lite_obs_core_video::init_textures()
     }
 
     d_ptr->render_texture = gs_texture_create(d_ptr->base_width, d_ptr->base_height, gs_color_format::GS_RGBA, 1, NULL, GS_RENDER_TARGET);
+    d_ptr->last_layers.clear();
+    d_ptr->canvas_valid = false;
 
     if (!d_ptr->render_texture)
         return false;
@@ -825,30 +1303,34 @@ bool lite_obs_core_video::init_textures()
 
 void lite_obs_core_video::graphics_thread_internal()
 {
-    do {
-        d_ptr->graphics = gs_create_graphics_system();
-        if (!d_ptr->graphics) {
-            break;
-        }
+    d_ptr->graphics = gs_create_graphics_system();
+    if (!d_ptr->graphics) {
+        blog(LOG_ERROR, "graphics_thread_internal: failed to create graphics");
+        return;
+    }
+
+    /* the context stays current on this thread until it exits instead of
+     * being entered every frame, other threads get it through the
+     * gs_yield_context handoff at the top of each frame */
+    gs_enter_contex(d_ptr->graphics);
+
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->deferred_mutex);
+        d_ptr->deferred_open = true;
+    }
 
-        gs_enter_contex(d_ptr->graphics);
+    do {
         if (d_ptr->ovi.gpu_conversion && !init_gpu_conversion()) {
             clear_gpu_conversion_textures();
-            gs_leave_context();
             break;
         }
 
-        if (!init_textures()) {
-            gs_leave_context();
+        if (!init_textures())
             break;
-        }
-        gs_leave_context();
 
         graphics_task_func();
     } while(false);
 
-    gs_enter_contex(d_ptr->graphics);
-
     for (size_t c = 0; c < NUM_CHANNELS; c++) {
         auto surface = d_ptr->mapped_surfaces[c].lock();
         if (surface) {
@@ -862,6 +1344,12 @@ void lite_obs_core_video::graphics_thread_internal()
     clear_gpu_conversion_textures();
     d_ptr->output_texture.reset();
 
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->deferred_mutex);
+        d_ptr->deferred_open = false;
+    }
+    free_deferred_graphics();
+
     gs_leave_context();
 
     d_ptr->graphics.reset();
@@ -871,6 +1359,7 @@ void lite_obs_core_video::graphics_thread_internal()
 
 void lite_obs_core_video::graphics_thread(void *param)
 {
+    TRACE_THREAD_NAME("graphics");
     lite_obs_core_video *p = (lite_obs_core_video *)param;
     p->graphics_thread_internal();
 }
@@ -904,7 +1393,7 @@ int lite_obs_core_video::lite_obs_start_video(obs_video_info *ovi)
         }
         return OBS_VIDEO_FAIL;
     }
-    d_ptr->video = video;
+    d_ptr->video.store(video);
 
     d_ptr->output_format = ovi->output_format;
     d_ptr->base_width = ovi->base_width;
@@ -912,6 +1401,19 @@ int lite_obs_core_video::lite_obs_start_video(obs_video_info *ovi)
     d_ptr->output_width = ovi->output_width;
     d_ptr->output_height = ovi->output_height;
     d_ptr->gpu_conversion = ovi->gpu_conversion;
+    d_ptr->using_packed_tex = ovi->gpu_conversion && ovi->packed_conversion;
+    d_ptr->using_mrt = ovi->gpu_conversion && !ovi->packed_conversion &&
+            mrt_conversion_supported(ovi->output_format, ovi->output_width, ovi->output_height);
+
+    if (!ovi->readback_depth)
+        ovi->readback_depth = NUM_TEXTURES;
+    else if (ovi->readback_depth < 2)
+        ovi->readback_depth = 2;
+    else if (ovi->readback_depth > MAX_NUM_TEXTURES)
+        ovi->readback_depth = MAX_NUM_TEXTURES;
+    d_ptr->num_textures = (int)ovi->readback_depth;
+    d_ptr->readback_forced = 0;
+    d_ptr->idle_interval_ns = ovi->idle_fps ? 1000000000ULL / ovi->idle_fps : 0;
 
     set_video_matrix(ovi);
     d_ptr->ovi = *ovi;
@@ -929,8 +1431,10 @@ bool lite_obs_core_video::lite_obs_video_active()
 
 void lite_obs_core_video::lite_obs_stop_video()
 {
-    if (d_ptr->video) {
-        d_ptr->video->video_output_stop();
+    auto video = d_ptr->video.load();
+    if (video) {
+        video->video_output_stop();
+        wake_idle();
         blog(LOG_DEBUG, "video output stopped.");
     }
 
@@ -942,16 +1446,16 @@ void lite_obs_core_video::lite_obs_stop_video()
         }
     }
 
-    if (d_ptr->video) {
-        d_ptr->video->video_output_close();
-        d_ptr->video.reset();
+    if (video) {
+        video->video_output_close();
+        d_ptr->video.store(nullptr);
         blog(LOG_DEBUG, "video output destroyed.");
     }
 }
 
 std::shared_ptr<video_output> lite_obs_core_video::core_video()
 {
-    return d_ptr->video;
+    return d_ptr->video.load();
 }
 
 obs_video_info *lite_obs_core_video::lite_obs_core_video_info()
@@ -3,6 +3,11 @@
 #include <memory>
 #include "lite_obs.h"
 
+const uint8_t *set_gpu_converted_plane(uint32_t width, uint32_t height,
+                                       uint32_t linesize_input,
+                                       uint32_t linesize_output,
+                                       const uint8_t *in, uint8_t *out);
+
 struct lite_obs_core_video_private;
 struct obs_graphics_context;
 class gs_texture;
@@ -26,10 +31,15 @@ public:
 
     static void graphics_thread(void *param);
     std::unique_ptr<graphics_subsystem> &graphics();
+    /* hands graphics objects to the graphics thread to be released with
+     * its context current, false if that thread is not running */
+    bool defer_graphics_free(std::shared_ptr<void> obj);
 
     uint32_t total_frames();
     uint32_t lagged_frames();
 
+    void lite_obs_core_video_get_stats(obs_stats *stats, bool reset);
+
 private:
     void set_video_matrix(obs_video_info *ovi);
     void calc_gpu_conversion_sizes();
@@ -47,18 +57,24 @@ private:
     void clear_gpu_frame_data(void);
 
     void video_sleep(bool raw_active, const bool gpu_active, uint64_t *p_time, uint64_t interval_ns);
+    void video_idle(obs_graphics_context *context);
+    void wake_idle();
+    void free_deferred_graphics();
     bool resolution_close(uint32_t width, uint32_t height);
     std::shared_ptr<gs_program> get_scale_effect_internal();
     std::shared_ptr<gs_program> get_scale_effect(uint32_t width, uint32_t height);
+    void unmap_output_surfaces();
     void stage_output_texture(int cur_texture);
     void render_convert_plane(std::shared_ptr<gs_texture> target);
+    void render_convert_planes(const std::shared_ptr<gs_texture> *targets, uint32_t count);
     void render_convert_texture(std::shared_ptr<gs_texture> texture);
     void render_all_sources();
     void render_main_texture();
     std::shared_ptr<gs_texture> render_output_texture();
-    void render_video(bool raw_active, const bool gpu_active, int cur_texture, int prev_texture);
-    bool download_frame(int prev_texture, struct video_data *frame);
-    void set_gpu_converted_data_internal(bool using_nv12_tex, class video_frame *output, const struct video_data *input, video_format format, uint32_t width, uint32_t height);
+    void render_video(bool raw_active, const bool gpu_active, int cur_texture);
+    bool texture_ready(int texture);
+    bool download_frame(int queued, struct video_data *frame);
+    void set_gpu_converted_data_internal(bool using_packed_tex, bool using_mrt, class video_frame *output, const struct video_data *input, video_format format, uint32_t width, uint32_t height);
     void set_gpu_converted_data(class video_frame *output, const struct video_data *input, const struct video_output_info *info);
     void output_video_data(video_data *input_frame, int count);
     void output_frame(bool raw_active, const bool gpu_active);
@@ -4,8 +4,10 @@
 #include "media-io/video_info.h"
 #include "media-io/audio_info.h"
 #include "media-io/media-io-defs.h"
+#include "util/stats.h"
 
 #define NUM_TEXTURES 2
+#define MAX_NUM_TEXTURES 8
 #define NUM_CHANNELS 3
 
 struct obs_audio_data {
@@ -28,11 +30,76 @@ struct obs_video_info {
     /** Use shaders to convert to different color formats */
     bool gpu_conversion{};
 
+    /** Convert into a single packed texture laid out like the final
+     *  frame and read it back at once.  Off by default, the extra packing
+     *  work makes it slower than drawing all planes in one multiple
+     *  render target pass (or one pass per plane where that does not
+     *  apply) */
+    bool packed_conversion{};
+
     video_colorspace colorspace{}; /**< YUV type (if YUV) */
     video_range_type range{};      /**< YUV range (if YUV) */
+
+    /** Depth of the GPU readback ring (0 = NUM_TEXTURES, max
+     *  MAX_NUM_TEXTURES).  With more than two slots, frames the GPU has
+     *  not finished copying stay queued instead of stalling the graphics
+     *  thread, at the cost of up to depth-1 frames of latency. */
+    uint32_t readback_depth{};
+
+    /** Canvas render rate while no output consumes frames (0 = do not
+     *  render at all).  The graphics thread otherwise sleeps until an
+     *  output starts and then picks up its frame timing where it was. */
+    uint32_t idle_fps{};
 };
 
 struct obs_audio_info {
     uint32_t samples_per_sec{};
     enum speaker_layout speakers{};
+
+    /** Frames mixed per audio tick (0 = AUDIO_OUTPUT_FRAMES, max
+     *  MAX_AUDIO_OUTPUT_FRAMES).  Smaller blocks lower the mixing latency,
+     *  e.g. 256 frames is ~5ms at 48kHz against ~21ms for 1024 */
+    uint32_t frames_per_block{};
+};
+
+/* counters are totals since the video/audio was (re)started, histograms
+ * cover the time since the last reset */
+struct obs_stats {
+    double video_fps{};
+    uint64_t video_avg_frame_time_ns{};
+    uint32_t total_frames{};  /**< Frames the graphics thread was due to render */
+    uint32_t lagged_frames{}; /**< Frames missed because rendering overran */
+
+    stats_histogram_snapshot render_time{}; /**< Render, convert, stage and readback per frame */
+    stats_histogram_snapshot map_wait{};    /**< Time blocked mapping the staged readback */
+    stats_histogram_snapshot pacer_jitter{}; /**< How late the graphics thread woke for each frame */
+    stats_histogram_snapshot readback_latency{}; /**< Staging to mapping, per frame */
+    uint32_t readback_queued{};  /**< Staged frames waiting on their GPU fence */
+    uint32_t readback_forced{};  /**< Maps forced before the fence signaled (ring full) */
+    uint64_t graphics_context_switches{}; /**< Times the GL context was made current on a thread */
+    uint32_t gl_calls{}; /**< GL calls issued rendering and converting the last frame */
+
+    uint32_t video_output_frames{}; /**< Frames handed out by the video output thread */
+    uint32_t skipped_frames{};      /**< Frames repeated because the cache was full */
+    uint32_t video_cache_frames{};  /**< Frames waiting in the video output cache */
+    uint32_t video_cache_size{};
+
+    uint64_t audio_ticks{};
+    uint32_t audio_buffering_ticks{};      /**< Ticks of buffering added so far */
+    uint32_t audio_buffering_wait_ticks{}; /**< Ticks still to wait before mixing */
+    stats_histogram_snapshot audio_tick_jitter{}; /**< How late each audio tick started */
+    uint32_t audio_overruns{};             /**< Ticks that started after the next one was due */
+};
+
+/* frame counters are relative to when the output started */
+struct obs_output_stats {
+    int total_frames{};        /**< Video frames passed to the output */
+    int dropped_frames{};      /**< Frames the output dropped (bandwidth/connection) */
+    uint32_t drawn_frames{};   /**< Frames the graphics thread was due to render */
+    uint32_t lagged_frames{};  /**< Frames lost to rendering lag/stalls */
+    uint32_t skipped_frames{}; /**< Frames lost because encoding could not keep up */
+
+    uint32_t video_encoder_queue{}; /**< Raw frames waiting for the video encoder */
+    uint32_t audio_encoder_queue{}; /**< Raw samples waiting for the audio encoder */
+    uint32_t interleave_queue{};    /**< Encoded packets waiting to be interleaved */
 };
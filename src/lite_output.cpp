@@ -4,6 +4,7 @@
 #include "util/threading.h"
 #include "util/circlebuf.h"
 #include "util/log.h"
+#include "util/trace.h"
 #include "lite_encoder_info.h"
 #include "lite_encoder.h"
 #include "lite_obs.h"
@@ -15,6 +16,7 @@
 #include <thread>
 #include <mutex>
 #include <list>
+#include <vector>
 
 struct lite_obs_output_private
 {
@@ -32,6 +34,7 @@ struct lite_obs_output_private
     os_event_t *stopping_event{};
     std::mutex interleaved_mutex;
     std::list<std::shared_ptr<encoder_packet>> interleaved_packets;
+    std::atomic<uint32_t> interleaved_depth{};
     int stop_code{};
 
     int reconnect_retry_sec{};
@@ -43,13 +46,17 @@ struct lite_obs_output_private
     std::atomic_bool reconnecting{};
     std::atomic_bool reconnect_thread_active{};
 
-    uint32_t starting_drawn_count{};
-    uint32_t starting_lagged_count{};
-    uint32_t starting_frame_count{};
+    std::atomic<uint32_t> starting_drawn_count{};
+    std::atomic<uint32_t> starting_lagged_count{};
+    std::atomic<uint32_t> starting_frame_count{};
+    std::atomic<uint32_t> starting_skipped_count{};
 
-    int total_frames{};
+    std::atomic_int total_frames{};
 
     std::atomic_bool active;
+
+    /* guards reassigning the pointers below against stats readers */
+    std::mutex media_mutex;
     std::weak_ptr<video_output> video{};
     std::weak_ptr<audio_output> audio{};
     std::weak_ptr<lite_obs_encoder> video_encoder{};
@@ -73,7 +80,9 @@ struct lite_obs_output_private
 
     std::string last_error_message{};
 
-    float audio_data[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES]{};
+    /* one audio output block per plane, sized in reset_raw_output */
+    uint32_t audio_frames{};
+    std::vector<uint8_t> audio_data[MAX_AV_PLANES]{};
 
     uint32_t sei_count_per_second{};
 
@@ -107,6 +116,7 @@ bool lite_obs_output::stopping()
 void lite_obs_output::free_packets()
 {
     d_ptr->interleaved_packets.clear();
+    d_ptr->interleaved_depth = 0;
 }
 
 void lite_obs_output::set_output_signal_callback(std::shared_ptr<lite_obs_output_signals> sig)
@@ -116,8 +126,11 @@ void lite_obs_output::set_output_signal_callback(std::shared_ptr<lite_obs_output
 
 bool lite_obs_output::lite_obs_output_create()
 {
-    d_ptr->video = obs.obs_core_video()->core_video();
-    d_ptr->audio = obs.obs_core_audio()->core_audio(); // todo
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->media_mutex);
+        d_ptr->video = obs.obs_core_video()->core_video();
+        d_ptr->audio = obs.obs_core_audio()->core_audio(); // todo
+    }
 
     d_ptr->reconnect_retry_sec = 2;
     d_ptr->reconnect_retry_max = 20;
@@ -146,10 +159,8 @@ void lite_obs_output::lite_obs_output_destroy()
         obs_output_actual_stop(true, 0);
 
     os_event_wait(d_ptr->stopping_event);
-    if (d_ptr->end_data_capture_thread_active) {
-        if (d_ptr->end_data_capture_thread.joinable())
-            d_ptr->end_data_capture_thread.join();
-    }
+    if (d_ptr->end_data_capture_thread.joinable())
+        d_ptr->end_data_capture_thread.join();
 
     if (i_output_valid())
         i_destroy();
@@ -187,6 +198,7 @@ bool lite_obs_output::lite_obs_output_actual_start()
     auto vo = d_ptr->video.lock();
     if (success && vo) {
         d_ptr->starting_frame_count = vo->video_output_get_total_frames();
+        d_ptr->starting_skipped_count = vo->video_output_get_skipped_frames();
         auto video = obs.obs_core_video();
         d_ptr->starting_drawn_count = video->total_frames();
         d_ptr->starting_lagged_count = video->lagged_frames();
@@ -265,6 +277,7 @@ void lite_obs_output::lite_obs_output_stop()
 
 void lite_obs_output::lite_obs_output_set_media(std::shared_ptr<video_output> vo, std::shared_ptr<audio_output> ao)
 {
+    std::lock_guard<std::mutex> lock(d_ptr->media_mutex);
     d_ptr->video = vo;
     d_ptr->audio = ao;
 }
@@ -297,7 +310,10 @@ void lite_obs_output::lite_obs_output_set_video_encoder(std::shared_ptr<lite_obs
         video_encoder->obs_encoder_remove_output(shared_from_this());
 
     encoder->obs_encoder_add_output(shared_from_this());
-    d_ptr->video_encoder = encoder;
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->media_mutex);
+        d_ptr->video_encoder = encoder;
+    }
 
     if (d_ptr->scaled_width && d_ptr->scaled_height)
         encoder->lite_obs_encoder_set_scaled_size(d_ptr->scaled_width, d_ptr->scaled_height);
@@ -321,8 +337,10 @@ void lite_obs_output::lite_obs_output_set_audio_encoder(std::shared_ptr<lite_obs
     if (audio_encoder == encoder)
         return;
 
-    audio_encoder->obs_encoder_remove_output(shared_from_this());
+    if (audio_encoder)
+        audio_encoder->obs_encoder_remove_output(shared_from_this());
     encoder->obs_encoder_add_output(shared_from_this());
+    std::lock_guard<std::mutex> lock(d_ptr->media_mutex);
     d_ptr->audio_encoders[idx] = encoder;
 }
 
@@ -351,6 +369,40 @@ int lite_obs_output::lite_obs_output_get_total_frames()
     return d_ptr->total_frames;
 }
 
+void lite_obs_output::lite_obs_output_get_stats(obs_output_stats *stats)
+{
+    *stats = obs_output_stats{};
+    stats->total_frames = d_ptr->total_frames;
+    stats->dropped_frames = i_get_dropped_frames();
+    stats->interleave_queue = d_ptr->interleaved_depth;
+
+    if (!d_ptr->active)
+        return;
+
+    auto video = obs.obs_core_video();
+    stats->drawn_frames = video->total_frames() - d_ptr->starting_drawn_count;
+    stats->lagged_frames = video->lagged_frames() - d_ptr->starting_lagged_count;
+
+    std::shared_ptr<video_output> vo;
+    std::shared_ptr<lite_obs_encoder> venc;
+    std::shared_ptr<lite_obs_encoder> aenc;
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->media_mutex);
+        vo = d_ptr->video.lock();
+        venc = d_ptr->video_encoder.lock();
+        aenc = d_ptr->audio_encoders[0].lock();
+    }
+
+    if (vo)
+        stats->skipped_frames = vo->video_output_get_skipped_frames() - d_ptr->starting_skipped_count;
+
+    if (venc)
+        stats->video_encoder_queue = venc->lite_obs_encoder_queue_depth();
+
+    if (aenc)
+        stats->audio_encoder_queue = aenc->lite_obs_encoder_queue_depth();
+}
+
 void lite_obs_output::lite_obs_output_set_preferred_size(uint32_t width, uint32_t height)
 {
     if (!i_has_video())
@@ -467,10 +519,8 @@ bool lite_obs_output::lite_obs_output_can_begin_data_capture()
     if (d_ptr->active)
         return false;
 
-    if (d_ptr->end_data_capture_thread_active) {
-        if (d_ptr->end_data_capture_thread.joinable())
-            d_ptr->end_data_capture_thread.join();
-    }
+    if (d_ptr->end_data_capture_thread.joinable())
+        d_ptr->end_data_capture_thread.join();
 
     return can_begin_data_capture(i_encoded(), i_has_video(), i_has_audio());
 }
@@ -524,6 +574,14 @@ void lite_obs_output::reset_raw_output()
         d_ptr->planes = get_audio_planes(info.format, info.speakers);
         d_ptr->total_audio_frames = 0;
         d_ptr->audio_size = get_audio_size(info.format, info.speakers, 1);
+
+        d_ptr->audio_frames = ao->audio_output_get_frames_per_block();
+        for (size_t i = 0; i < MAX_AV_PLANES; i++) {
+            if (i < d_ptr->planes)
+                d_ptr->audio_data[i].resize(d_ptr->audio_frames * d_ptr->audio_size);
+            else
+                d_ptr->audio_data[i].clear();
+        }
     }
 
     d_ptr->audio_start_ts = 0;
@@ -922,6 +980,7 @@ void lite_obs_output::send_interleaved()
 
 void lite_obs_output::interleave_packets_internal(std::shared_ptr<struct encoder_packet> packet)
 {
+    TRACE_SCOPE("interleave_packets");
     if (!d_ptr->active)
         return;
 
@@ -961,6 +1020,8 @@ void lite_obs_output::interleave_packets_internal(std::shared_ptr<struct encoder
             send_interleaved();
         }
     }
+
+    d_ptr->interleaved_depth = (uint32_t)d_ptr->interleaved_packets.size();
 }
 
 void lite_obs_output::interleave_packets(void *data, std::shared_ptr<struct encoder_packet> packet)
@@ -1047,7 +1108,7 @@ void lite_obs_output::default_raw_audio_callback_internal(size_t mix_idx, struct
         d_ptr->audio_start_ts = out.timestamp;
     }
 
-    frame_size_bytes = AUDIO_OUTPUT_FRAMES * d_ptr->audio_size;
+    frame_size_bytes = d_ptr->audio_frames * d_ptr->audio_size;
 
     for (size_t i = 0; i < d_ptr->planes; i++)
         circlebuf_push_back(&d_ptr->audio_buffer[mix_idx][i],
@@ -1059,17 +1120,17 @@ void lite_obs_output::default_raw_audio_callback_internal(size_t mix_idx, struct
     while (d_ptr->audio_buffer[mix_idx][0].size > frame_size_bytes) {
         for (size_t i = 0; i < d_ptr->planes; i++) {
             circlebuf_pop_front(&d_ptr->audio_buffer[mix_idx][i],
-                                d_ptr->audio_data[i],
+                                d_ptr->audio_data[i].data(),
                                 frame_size_bytes);
-            out.data[i] = (uint8_t *)d_ptr->audio_data[i];
+            out.data[i] = d_ptr->audio_data[i].data();
         }
 
-        out.frames = AUDIO_OUTPUT_FRAMES;
+        out.frames = d_ptr->audio_frames;
         out.timestamp = d_ptr->audio_start_ts +
                 audio_frames_to_ns(d_ptr->sample_rate,
                                    d_ptr->total_audio_frames);
 
-        d_ptr->total_audio_frames += AUDIO_OUTPUT_FRAMES;
+        d_ptr->total_audio_frames += d_ptr->audio_frames;
 
         i_raw_audio(&out);
     }
@@ -1099,7 +1160,7 @@ void lite_obs_output::hook_data_capture(bool encoded, bool has_video, bool has_a
         }
         if (has_video) {
             auto info = obs.obs_core_video()->lite_obs_core_video_info();
-            uint32_t fps = info->fps_num / info->fps_den;
+            uint32_t fps = info->fps_den ? info->fps_num / info->fps_den : 0;
             uint32_t target_freq = d_ptr->sei_count_per_second == 0 ? 5 : d_ptr->sei_count_per_second;
             auto vc = d_ptr->video_encoder.lock();
             vc->lite_obs_encoder_set_sei_rate(fps / target_freq);
@@ -1191,7 +1252,7 @@ void lite_obs_output::log_frame_info()
     if (drawn && lagged)
         blog(LOG_INFO, "Output: Number of lagged frames due to rendering lag/stalls: %u (%0.1f%%)", lagged, percentage_lagged);
     if (total && dropped)
-        blog(LOG_INFO, "Output '%s': Number of dropped frames due to insufficient bandwidth/connection stalls: %d (%0.1f%%)", dropped, percentage_dropped);
+        blog(LOG_INFO, "Output: Number of dropped frames due to insufficient bandwidth/connection stalls: %d (%0.1f%%)", dropped, percentage_dropped);
 }
 
 void lite_obs_output::end_data_capture_thread_internal()
@@ -1256,10 +1317,8 @@ void lite_obs_output::lite_obs_output_end_data_capture_internal(bool sig)
     if (d_ptr->video.lock())
         log_frame_info();
 
-    if (d_ptr->end_data_capture_thread_active) {
-        if (d_ptr->end_data_capture_thread.joinable())
-            d_ptr->end_data_capture_thread.join();
-    }
+    if (d_ptr->end_data_capture_thread.joinable())
+        d_ptr->end_data_capture_thread.join();
 
     d_ptr->end_data_capture_thread_active = true;
     d_ptr->end_data_capture_thread = std::thread(lite_obs_output::end_data_capture_thread, this);
@@ -1278,6 +1337,7 @@ void lite_obs_output::lite_obs_output_end_data_capture()
 
 void lite_obs_output::lite_obs_output_remove_encoder(std::shared_ptr<lite_obs_encoder> encoder)
 {
+    std::lock_guard<std::mutex> lock(d_ptr->media_mutex);
     if (d_ptr->video_encoder.lock() == encoder)
         d_ptr->video_encoder.reset();
     else {
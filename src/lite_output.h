@@ -63,6 +63,8 @@ public:
     uint64_t lite_obs_output_get_total_bytes();
     int lite_obs_output_get_frames_dropped();
     int lite_obs_output_get_total_frames();
+    /* lock-free, safe to poll from any thread */
+    void lite_obs_output_get_stats(struct obs_output_stats *stats);
 
     void lite_obs_output_set_preferred_size(uint32_t width, uint32_t height);
     uint32_t lite_obs_output_get_width();
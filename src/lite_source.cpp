@@ -2,17 +2,100 @@
 #include "util/circlebuf.h"
 #include "util/log.h"
 #include "lite_obs.h"
+#include "lite_obs_core_audio.h"
+#include "lite_obs_core_video.h"
+#include "media-io/audio_output.h"
 #include "media-io/audio_info.h"
 #include "media-io/video_info.h"
 #include "media-io/audio_resampler.h"
+#include "media-io/audio_math.h"
+#include "media-io/video_frame.h"
+#include "media-io/video-matrices.h"
+#include "graphics/gs_subsystem.h"
+#include "graphics/gs_texture.h"
+#include "graphics/gs_texture_render.h"
+#include "graphics/gs_program.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <mutex>
 #include <list>
+#include <deque>
+#include <vector>
+
+/* frames waiting for their render time, the oldest is dropped past this */
+#define MAX_ASYNC_FRAMES 30
+/* timestamps further than this from the render time restart the timing */
+#define MAX_TS_VAR 2000000000ULL
 
 struct audio_cb_info {
     obs_source_audio_capture callback{};
     void *param{};
 };
 
+struct async_frame {
+    video_frame_buffer buffer{};
+    uint64_t timestamp{};
+    uint32_t width{};
+    uint32_t height{};
+    video_format format{};
+    video_colorspace colorspace{};
+    video_range_type range{};
+    bool flip{};
+};
+
+struct async_plane_info {
+    gs_color_format format;
+    uint32_t width_div;
+    uint32_t height_div;
+};
+
+/* the planes each format is uploaded as and the technique converting them,
+ * packed 4:2:2 formats take one rgba texel per two pixels */
+struct async_format_info {
+    video_format format;
+    const char *tech;
+    uint32_t planes;
+    async_plane_info plane[MAX_AV_PLANES];
+    bool alpha{};
+};
+
+static constexpr gs_color_format R8 = gs_color_format::GS_R8;
+static constexpr gs_color_format R8G8 = gs_color_format::GS_R8G8;
+static constexpr gs_color_format RGBA = gs_color_format::GS_RGBA;
+
+static const async_format_info async_formats[] = {
+    {video_format::VIDEO_FORMAT_I420, "Convert_I420_Reverse", 3, {{R8, 1, 1}, {R8, 2, 2}, {R8, 2, 2}}},
+    {video_format::VIDEO_FORMAT_NV12, "Convert_NV12_Reverse", 2, {{R8, 1, 1}, {R8G8, 2, 2}}},
+    {video_format::VIDEO_FORMAT_I422, "Convert_I422_Reverse", 3, {{R8, 1, 1}, {R8, 2, 1}, {R8, 2, 1}}},
+    {video_format::VIDEO_FORMAT_I444, "Convert_I444_Reverse", 3, {{R8, 1, 1}, {R8, 1, 1}, {R8, 1, 1}}},
+    {video_format::VIDEO_FORMAT_I40A, "Convert_I40A_Reverse", 4, {{R8, 1, 1}, {R8, 2, 2}, {R8, 2, 2}, {R8, 1, 1}}, true},
+    {video_format::VIDEO_FORMAT_I42A, "Convert_I42A_Reverse", 4, {{R8, 1, 1}, {R8, 2, 1}, {R8, 2, 1}, {R8, 1, 1}}, true},
+    {video_format::VIDEO_FORMAT_YUVA, "Convert_YUVA_Reverse", 4, {{R8, 1, 1}, {R8, 1, 1}, {R8, 1, 1}, {R8, 1, 1}}, true},
+    {video_format::VIDEO_FORMAT_YUY2, "Convert_YUY2_Reverse", 1, {{RGBA, 2, 1}}},
+    {video_format::VIDEO_FORMAT_UYVY, "Convert_UYVY_Reverse", 1, {{RGBA, 2, 1}}},
+    {video_format::VIDEO_FORMAT_YVYU, "Convert_YVYU_Reverse", 1, {{RGBA, 2, 1}}},
+    {video_format::VIDEO_FORMAT_AYUV, "Convert_AYUV_Reverse", 1, {{RGBA, 1, 1}}, true},
+    /* drawn as uploaded */
+    {video_format::VIDEO_FORMAT_RGBA, nullptr, 1, {{RGBA, 1, 1}}, true},
+};
+
+static const async_format_info *get_async_format(video_format format)
+{
+    for (auto &info : async_formats) {
+        if (info.format == format)
+            return &info;
+    }
+
+    return nullptr;
+}
+
+static inline uint32_t async_plane_row_size(const async_plane_info &plane, uint32_t width)
+{
+    return width / plane.width_div * gs_get_format_bpp(plane.format) / 8;
+}
+
 struct lite_source_private
 {
     std::unique_ptr<lite_source_impl> impl{};
@@ -63,9 +146,18 @@ struct lite_source_private
     uint64_t audio_ts{};
     circlebuf audio_input_buf[MAX_AUDIO_CHANNELS]{};
     size_t last_audio_input_buf_size{};
-    float *audio_output_buf[MAX_AUDIO_MIXES][MAX_AUDIO_CHANNELS]{};
+    /* one block per output channel, shared by every mix; allocated on the
+     * first tick that renders the source */
+    std::vector<float> audio_output_data{};
+    float *audio_output_buf[MAX_AUDIO_CHANNELS]{};
     resample_info sample_info{};
+    resample_info resample_dst{};
     std::shared_ptr<audio_resampler> resampler{};
+
+    /* what audio_render took for the current tick, audio thread only */
+    uint64_t render_ts{};
+    uint32_t render_mixers{};
+    float render_gain[MAX_AUDIO_CHANNELS]{};
     std::mutex audio_buf_mutex;
     std::mutex audio_mutex;
     std::mutex audio_cb_mutex;
@@ -79,39 +171,39 @@ struct lite_source_private
     int64_t last_sync_offset{};
     float balance{};
 
-    /* async video data */
-    //    gs_texture_t *async_textures[MAX_AV_PLANES];
-    //    gs_texrender_t *async_texrender;
-    //    struct obs_source_frame *cur_async_frame;
-    //    bool async_gpu_conversion;
-    //    enum video_format async_format;
-    //    bool async_full_range;
-    //    enum video_format async_cache_format;
-    //    bool async_cache_full_range;
-    //    enum gs_color_format async_texture_formats[MAX_AV_PLANES];
-    //    int async_channel_count;
-    //    bool async_flip;
-    //    bool async_flip_h;
-    //    bool async_active;
-    //    bool async_update_texture;
-    //    bool async_unbuffered;
-    //    bool async_decoupled;
-    //    struct obs_source_frame *async_preload_frame;
-    //    DARRAY(struct async_frame) async_cache;
-    //    DARRAY(struct obs_source_frame *) async_frames;
+    /* async video data, the frame queue is shared with the threads calling
+     * output_video, the textures and cur_async_frame are graphics thread only */
+    std::shared_ptr<gs_texture> async_textures[MAX_AV_PLANES]{};
+    std::unique_ptr<gs_texture_render> async_texrender{};
+    std::shared_ptr<gs_texture> async_texture{};
+    std::unique_ptr<async_frame> cur_async_frame{};
+    video_format async_format{};
+    video_format async_failed_format{};
+    bool async_flip{};
+    std::vector<std::unique_ptr<async_frame>> async_cache{};
+    std::deque<std::unique_ptr<async_frame>> async_frames{};
     std::mutex async_mutex;
-    //    uint32_t async_width;
-    //    uint32_t async_height;
-    //    uint32_t async_cache_width;
-    //    uint32_t async_cache_height;
-    //    uint32_t async_convert_width[MAX_AV_PLANES];
-    //    uint32_t async_convert_height[MAX_AV_PLANES];
+    uint32_t async_width{};
+    uint32_t async_height{};
+
+    std::mutex transform_mutex;
+    obs_transform_info transform{};
+    bool visible = true;
+
+    std::atomic<uint64_t> video_serial{};
 };
 
+static std::atomic<uint64_t> last_video_serial{};
 
-std::shared_ptr<lite_source> obs_source_create(const std::string &id)
+static inline uint64_t next_video_serial()
 {
-    auto source = std::make_shared<lite_source>(id);
+    return ++last_video_serial;
+}
+
+
+std::shared_ptr<lite_source> obs_source_create(const std::string &id, uint32_t output_flags)
+{
+    auto source = std::make_shared<lite_source>(id, output_flags);
     obs.add_source(source, source->is_audio_source());
     return source;
 }
@@ -121,11 +213,14 @@ void obs_source_destroy(std::shared_ptr<lite_source> source)
     obs.remove_source(source);
 }
 
-lite_source::lite_source(const std::string &id)
+lite_source::lite_source(const std::string &id, uint32_t output_flags)
 {
     d_ptr = std::make_unique<lite_source_private>();
     d_ptr->impl = std::make_unique<lite_source_impl>();
+    d_ptr->impl->id = id;
+    d_ptr->impl->output_flags = output_flags;
 
+    d_ptr->video_serial = next_video_serial();
     d_ptr->user_volume = 1.0f;
     d_ptr->volume = 1.0f;
     d_ptr->sync_offset = 0;
@@ -133,41 +228,31 @@ lite_source::lite_source(const std::string &id)
     d_ptr->audio_active = true;
 
 
-    if (is_audio_source())
-        allocate_audio_output_buffer();
-
     d_ptr->audio_mixers = 0xFF;
     d_ptr->enabled = true;
 }
 
 lite_source::~lite_source()
 {
-    blog(LOG_DEBUG, "%ssource '%s' destroyed", d_ptr->impl->id.c_str());
-
-//    for (i = 0; i < source->async_cache.num; i++)
-//        obs_source_frame_decref(source->async_cache.array[i].frame);
-
-//    gs_enter_context(obs->video.graphics);
-//    if (source->async_texrender)
-//        gs_texrender_destroy(source->async_texrender);
-//    if (source->async_prev_texrender)
-//        gs_texrender_destroy(source->async_prev_texrender);
-//    for (size_t c = 0; c < MAX_AV_PLANES; c++) {
-//        gs_texture_destroy(source->async_textures[c]);
-//        gs_texture_destroy(source->async_prev_textures[c]);
-//    }
-//    if (source->filter_texrender)
-//        gs_texrender_destroy(source->filter_texrender);
-//    if (source->async_holder_image)
-//        gs_texture_destroy(source->async_holder_image);
-//    gs_leave_context();
+    blog(LOG_DEBUG, "source '%s' destroyed", d_ptr->impl->id.c_str());
+
+    /* the last reference can drop on any thread, the audio thread
+     * included, so the textures go to the graphics thread instead of
+     * waiting here for the context */
+    auto video = obs.obs_core_video();
+    for (size_t c = 0; c < MAX_AV_PLANES; c++) {
+        if (d_ptr->async_textures[c])
+            video->defer_graphics_free(std::move(d_ptr->async_textures[c]));
+    }
+    if (d_ptr->async_texrender)
+        video->defer_graphics_free(std::shared_ptr<gs_texture_render>(std::move(d_ptr->async_texrender)));
+    if (d_ptr->async_texture)
+        video->defer_graphics_free(std::move(d_ptr->async_texture));
 
 //    for (i = 0; i < MAX_AV_PLANES; i++)
 //        bfree(source->audio_data.data[i]);
-//    for (i = 0; i < MAX_AUDIO_CHANNELS; i++)
-//        circlebuf_free(&source->audio_input_buf[i]);
-//    audio_resampler_destroy(source->resampler);
-//    bfree(source->audio_output_buf[0][0]);
+    for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++)
+        circlebuf_free(&d_ptr->audio_input_buf[i]);
 //    bfree(source->audio_mix_buf[0]);
 
 //    obs_source_frame_destroy(source->async_preload_frame);
@@ -201,19 +286,631 @@ bool lite_source::is_audio_source()
     return d_ptr->impl->output_flags & OBS_SOURCE_AUDIO;
 }
 
-void lite_source::allocate_audio_output_buffer()
+bool lite_source::is_async_video_source()
+{
+    return (d_ptr->impl->output_flags & OBS_SOURCE_ASYNC_VIDEO) == OBS_SOURCE_ASYNC_VIDEO;
+}
+
+void lite_source::allocate_audio_output_buffer(size_t channels, uint32_t frames)
+{
+    d_ptr->audio_output_data.assign(channels * frames, 0.0f);
+
+    for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++)
+        d_ptr->audio_output_buf[i] = i < channels ? d_ptr->audio_output_data.data() + frames * i : nullptr;
+}
+
+#define TS_SMOOTHING_THRESHOLD 70000000ULL
+#define MAX_BUF_SIZE (1000 * AUDIO_OUTPUT_FRAMES * sizeof(float))
+
+static inline bool resample_info_equal(const resample_info &a, const resample_info &b)
+{
+    return a.samples_per_sec == b.samples_per_sec && a.format == b.format &&
+            a.speakers == b.speakers;
+}
+
+static inline uint64_t uint64_diff(uint64_t ts1, uint64_t ts2)
+{
+    return (ts1 < ts2) ? (ts2 - ts1) : (ts1 - ts2);
+}
+
+/* rounds to the nearest frame, the block timestamps are truncated ns */
+static inline size_t convert_time_to_frames(size_t sample_rate, uint64_t t)
+{
+    return (size_t)ns_to_audio_frames(sample_rate, t + 500000000ULL / sample_rate);
+}
+
+bool lite_source::reset_resampler(const obs_source_audio *audio, const audio_output_info *aoi)
+{
+    resample_info src = {audio->samples_per_sec, audio->format, audio->speakers};
+    resample_info dst = {aoi->samples_per_sec, aoi->format, aoi->speakers};
+
+    if (resample_info_equal(src, d_ptr->sample_info) &&
+            resample_info_equal(dst, d_ptr->resample_dst))
+        return !d_ptr->audio_failed;
+
+    d_ptr->sample_info = src;
+    d_ptr->resample_dst = dst;
+    d_ptr->resampler.reset();
+    d_ptr->audio_failed = false;
+
+    if (resample_info_equal(src, dst))
+        return true;
+
+    auto resampler = std::make_shared<audio_resampler>();
+    if (!resampler->create(&dst, &src)) {
+        blog(LOG_ERROR, "creation of resampler failed");
+        d_ptr->audio_failed = true;
+        return false;
+    }
+
+    d_ptr->resampler = resampler;
+    return true;
+}
+
+void lite_source::output_audio(const obs_source_audio *audio_in)
+{
+    if (!audio_in || !audio_in->frames)
+        return;
+
+    auto audio = obs.obs_core_audio()->core_audio();
+    if (!audio)
+        return;
+
+    const audio_output_info *aoi = audio->audio_output_get_info();
+    size_t channels = audio->audio_output_get_channels();
+    size_t sample_rate = aoi->samples_per_sec;
+
+    std::lock_guard<std::mutex> lock(d_ptr->audio_mutex);
+    if (!reset_resampler(audio_in, aoi))
+        return;
+
+    const uint8_t *const *data = audio_in->data;
+    uint8_t *output[MAX_AV_PLANES] = {};
+    uint32_t frames = audio_in->frames;
+    uint64_t ts = audio_in->timestamp;
+
+    if (d_ptr->resampler) {
+        uint64_t offset = 0;
+        if (!d_ptr->resampler->do_resample(output, &frames, &offset, audio_in->data, audio_in->frames))
+            return;
+
+        data = output;
+        ts -= offset;
+    }
+
+    if (!frames)
+        return;
+
+    size_t size = frames * sizeof(float);
+
+    std::lock_guard<std::mutex> buf_lock(d_ptr->audio_buf_mutex);
+
+    /* small timestamp jitter from the capture side is smoothed out, a
+     * larger jump restarts the source's timeline */
+    bool jump = !d_ptr->next_audio_ts_min ||
+            uint64_diff(ts, d_ptr->next_audio_ts_min) > TS_SMOOTHING_THRESHOLD;
+    if (!jump)
+        ts = d_ptr->next_audio_ts_min;
+
+    if (jump || !d_ptr->audio_input_buf[0].size ||
+            d_ptr->audio_input_buf[0].size + size > MAX_BUF_SIZE) {
+        for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++)
+            circlebuf_pop_front(&d_ptr->audio_input_buf[i], NULL,
+                                d_ptr->audio_input_buf[i].size);
+        d_ptr->audio_ts = ts;
+    }
+
+    for (size_t i = 0; i < channels; i++)
+        circlebuf_push_back(&d_ptr->audio_input_buf[i], data[i], size);
+
+    d_ptr->next_audio_ts_min = ts + audio_frames_to_ns(sample_rate, frames);
+}
+
+std::unique_ptr<async_frame> lite_source::cache_async_frame(const obs_source_frame *frame)
+{
+    std::unique_ptr<async_frame> cached;
+
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->async_mutex);
+        if (!d_ptr->async_cache.empty()) {
+            cached = std::move(d_ptr->async_cache.back());
+            d_ptr->async_cache.pop_back();
+        }
+    }
+
+    if (!cached)
+        cached = std::make_unique<async_frame>();
+
+    if (cached->format != frame->format || cached->width != frame->width ||
+            cached->height != frame->height) {
+        cached->buffer.video_frame_buffer_init(frame->format, frame->width, frame->height);
+        cached->format = frame->format;
+        cached->width = frame->width;
+        cached->height = frame->height;
+    }
+
+    cached->timestamp = frame->timestamp;
+    cached->colorspace = frame->colorspace;
+    cached->range = frame->range;
+    cached->flip = frame->flip;
+    return cached;
+}
+
+void lite_source::output_video(const obs_source_frame *frame)
+{
+    if (!frame || !is_async_video_source())
+        return;
+
+    auto info = get_async_format(frame->format);
+    if (!info || !frame->width || !frame->height) {
+        std::lock_guard<std::mutex> lock(d_ptr->async_mutex);
+        if (d_ptr->async_failed_format != frame->format) {
+            d_ptr->async_failed_format = frame->format;
+            blog(LOG_ERROR, "source '%s': unsupported async video format %d (%ux%u)",
+                 d_ptr->impl->id.c_str(), (int)frame->format, frame->width, frame->height);
+        }
+        return;
+    }
+
+    auto cached = cache_async_frame(frame);
+    const video_frame &dst = cached->buffer.frame();
+
+    for (uint32_t i = 0; i < info->planes; i++) {
+        const async_plane_info &plane = info->plane[i];
+        uint32_t row_size = async_plane_row_size(plane, frame->width);
+        uint32_t rows = frame->height / plane.height_div;
+
+        if (frame->linesize[i] == dst.linesize[i]) {
+            memcpy(dst.data[i], frame->data[i], (size_t)dst.linesize[i] * rows);
+            continue;
+        }
+
+        for (uint32_t y = 0; y < rows; y++)
+            memcpy(dst.data[i] + (size_t)dst.linesize[i] * y,
+                   frame->data[i] + (size_t)frame->linesize[i] * y, row_size);
+    }
+
+    std::lock_guard<std::mutex> lock(d_ptr->async_mutex);
+    if (d_ptr->async_frames.size() >= MAX_ASYNC_FRAMES) {
+        d_ptr->async_cache.push_back(std::move(d_ptr->async_frames.front()));
+        d_ptr->async_frames.pop_front();
+    }
+
+    d_ptr->async_frames.push_back(std::move(cached));
+}
+
+/* moves the queued frame closest to render_ts into cur_async_frame, frames
+ * before it are never shown; returns whether the frame changed */
+bool lite_source::ready_async_frame(uint64_t render_ts)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->async_mutex);
+    if (d_ptr->async_frames.empty())
+        return false;
+
+    /* frame timestamps are mapped onto the render timeline, a source
+     * starting out or jumping in time is lined up with the current render */
+    uint64_t first_ts = d_ptr->async_frames.front()->timestamp;
+    if (!d_ptr->timing_set ||
+            uint64_diff(first_ts + d_ptr->timing_adjust, render_ts) > MAX_TS_VAR) {
+        d_ptr->timing_adjust = render_ts - first_ts;
+        d_ptr->timing_set = true;
+    }
+
+    bool changed = false;
+    while (!d_ptr->async_frames.empty()) {
+        uint64_t next_ts = d_ptr->async_frames.front()->timestamp + d_ptr->timing_adjust;
+
+        if (d_ptr->cur_async_frame) {
+            uint64_t cur_ts = d_ptr->cur_async_frame->timestamp + d_ptr->timing_adjust;
+            if (next_ts > render_ts && next_ts - render_ts >= uint64_diff(cur_ts, render_ts))
+                break;
+
+            d_ptr->async_cache.push_back(std::move(d_ptr->cur_async_frame));
+        }
+
+        d_ptr->cur_async_frame = std::move(d_ptr->async_frames.front());
+        d_ptr->async_frames.pop_front();
+        changed = true;
+    }
+
+    return changed;
+}
+
+void lite_source::free_async_textures()
 {
-    size_t size = sizeof(float) * AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS *
-            MAX_AUDIO_MIXES;
-    float *ptr = (float *)malloc(size);
-    memset(ptr, 0, size);
+    for (size_t c = 0; c < MAX_AV_PLANES; c++)
+        d_ptr->async_textures[c].reset();
+
+    d_ptr->async_texrender.reset();
+    d_ptr->async_texture.reset();
+    d_ptr->async_format = video_format::VIDEO_FORMAT_NONE;
+    d_ptr->async_width = 0;
+    d_ptr->async_height = 0;
+}
+
+bool lite_source::init_async_textures()
+{
+    auto frame = d_ptr->cur_async_frame.get();
+    auto info = get_async_format(frame->format);
+
+    free_async_textures();
+
+    for (uint32_t c = 0; c < info->planes; c++) {
+        const async_plane_info &plane = info->plane[c];
+        d_ptr->async_textures[c] = gs_texture_create(frame->width / plane.width_div,
+                                                     frame->height / plane.height_div,
+                                                     plane.format, 1, NULL, GS_DYNAMIC);
+        if (!d_ptr->async_textures[c]) {
+            free_async_textures();
+            return false;
+        }
+    }
+
+    if (info->tech)
+        d_ptr->async_texrender = std::make_unique<gs_texture_render>(gs_color_format::GS_RGBA,
+                                                                     gs_zstencil_format::GS_ZS_NONE);
+
+    d_ptr->async_format = frame->format;
+    d_ptr->async_width = frame->width;
+    d_ptr->async_height = frame->height;
+
+    blog(LOG_INFO, "source '%s': async video %ux%u, format %d",
+         d_ptr->impl->id.c_str(), frame->width, frame->height, (int)frame->format);
+    return true;
+}
+
+bool lite_source::update_async_textures()
+{
+    auto frame = d_ptr->cur_async_frame.get();
+    auto info = get_async_format(frame->format);
+
+    if (d_ptr->async_format != frame->format || d_ptr->async_width != frame->width ||
+            d_ptr->async_height != frame->height) {
+        if (!init_async_textures())
+            return false;
+    }
+
+    auto textures = d_ptr->async_textures;
+    const video_frame &planes = frame->buffer.frame();
+
+    for (uint32_t c = 0; c < info->planes; c++)
+        textures[c]->gs_texture_set_image(planes.data[c], planes.linesize[c], false);
+
+    d_ptr->async_flip = frame->flip;
+
+    if (!info->tech) {
+        d_ptr->async_texture = textures[0];
+        return true;
+    }
+
+    static const gs_effect_param_id image_params[] = {
+        gs_effect_param_id::GS_PARAM_IMAGE, gs_effect_param_id::GS_PARAM_IMAGE1,
+        gs_effect_param_id::GS_PARAM_IMAGE2, gs_effect_param_id::GS_PARAM_IMAGE3,
+    };
+    float matrix[16];
+    float range_min[3];
+    float range_max[3];
+    video_format_get_parameters(frame->colorspace, frame->range, matrix, range_min, range_max);
+
+    auto program = gs_graphics_subsystem()->gs_get_effect_by_name(info->tech);
+    if (!program)
+        return false;
+
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_WIDTH, (float)frame->width);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_WIDTH_D2, (float)frame->width * 0.5f);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_HEIGHT, (float)frame->height);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_HEIGHT_D2, (float)frame->height * 0.5f);
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_RANGE_MIN, range_min, sizeof(range_min));
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_RANGE_MAX, range_max, sizeof(range_max));
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC0, glm::vec4(matrix[0], matrix[1], matrix[2], matrix[3]));
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC1, glm::vec4(matrix[4], matrix[5], matrix[6], matrix[7]));
+    program->gs_effect_set_param(gs_effect_param_id::GS_PARAM_COLOR_VEC2, glm::vec4(matrix[8], matrix[9], matrix[10], matrix[11]));
+    for (uint32_t c = 0; c < info->planes; c++)
+        program->gs_effect_set_texture(image_params[c], textures[c]);
+
+    d_ptr->async_texrender->gs_texrender_reset();
+    if (!d_ptr->async_texrender->gs_texrender_begin(frame->width, frame->height))
+        return false;
+
+    gs_set_cur_effect(program);
+    gs_enable_blending(false);
+
+    gs_technique_begin();
+    gs_draw(gs_draw_mode::GS_TRIS, 0, 3);
+    gs_technique_end();
+
+    gs_enable_blending(true);
+    d_ptr->async_texrender->gs_texrender_end();
+
+    d_ptr->async_texture = d_ptr->async_texrender->gs_texrender_get_texture();
+    return true;
+}
+
+void lite_source::async_video_tick(uint64_t render_ts)
+{
+    if (!ready_async_frame(render_ts))
+        return;
+
+    if (!update_async_textures())
+        d_ptr->async_texture.reset();
+
+    d_ptr->video_serial = next_video_serial();
+}
+
+uint64_t lite_source::video_serial()
+{
+    return d_ptr->video_serial;
+}
+
+static glm::mat4x4 transform_matrix(const obs_transform_info &info, float cx, float cy)
+{
+    glm::vec2 scale = info.scale;
+    if (info.bounds.x > 0.0f && info.bounds.y > 0.0f)
+        scale = info.bounds / glm::vec2(cx, cy);
+
+    glm::mat4x4 mat = glm::translate(glm::mat4x4(1.0f), glm::vec3(info.pos, 0.0f));
+    mat = glm::rotate(mat, glm::radians(info.rot), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(mat, glm::vec3(scale, 1.0f));
+}
+
+static void transform_box(const glm::mat4x4 &mat, float cx, float cy, glm::vec2 *min, glm::vec2 *max)
+{
+    const glm::vec4 corners[4] = {
+        mat * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f),
+        mat * glm::vec4(cx, 0.0f, 0.0f, 1.0f),
+        mat * glm::vec4(0.0f, cy, 0.0f, 1.0f),
+        mat * glm::vec4(cx, cy, 0.0f, 1.0f),
+    };
+
+    *min = *max = glm::vec2(corners[0]);
+    for (auto &corner : corners) {
+        *min = glm::min(*min, glm::vec2(corner));
+        *max = glm::max(*max, glm::vec2(corner));
+    }
+}
+
+void lite_source::video_render(graphics_subsystem *graphics)
+{
+    auto texture = d_ptr->async_texture;
+    if (!texture)
+        return;
+
+    float cx = (float)texture->gs_texture_get_width();
+    float cy = (float)texture->gs_texture_get_height();
+    glm::mat4x4 mat = transform_matrix(transform(), cx, cy);
+
+    graphics->gs_sprite_batch_add(texture, mat, d_ptr->async_flip ? GS_FLIP_V : 0, 0, 0);
+}
+
+bool lite_source::video_bounds(glm::vec2 *min, glm::vec2 *max)
+{
+    uint32_t cx = 0, cy = 0;
+
+    if (d_ptr->async_texture) {
+        cx = d_ptr->async_texture->gs_texture_get_width();
+        cy = d_ptr->async_texture->gs_texture_get_height();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(d_ptr->async_mutex);
+        for (auto &frame : d_ptr->async_frames) {
+            cx = std::max(cx, frame->width);
+            cy = std::max(cy, frame->height);
+        }
+    }
+
+    if (!cx || !cy)
+        return false;
+
+    glm::mat4x4 mat = transform_matrix(transform(), (float)cx, (float)cy);
+    transform_box(mat, (float)cx, (float)cy, min, max);
+    return true;
+}
+
+bool lite_source::video_opaque_bounds(glm::vec2 *min, glm::vec2 *max)
+{
+    auto texture = d_ptr->async_texture;
+    if (!texture)
+        return false;
+
+    if (!(d_ptr->impl->output_flags & OBS_SOURCE_OPAQUE)) {
+        auto info = get_async_format(d_ptr->async_format);
+        if (!info || info->alpha)
+            return false;
+    }
+
+    obs_transform_info info = transform();
+    float rot = fmodf(fabsf(info.rot), 90.0f);
+    if (rot > 0.01f && rot < 89.99f)
+        return false;
+
+    float cx = (float)texture->gs_texture_get_width();
+    float cy = (float)texture->gs_texture_get_height();
+    transform_box(transform_matrix(info, cx, cy), cx, cy, min, max);
+    return true;
+}
+
+void lite_source::set_transform(const obs_transform_info &info)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->transform_mutex);
+    d_ptr->transform = info;
+    d_ptr->video_serial = next_video_serial();
+}
+
+obs_transform_info lite_source::transform()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->transform_mutex);
+    return d_ptr->transform;
+}
+
+void lite_source::set_visible(bool visible)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->transform_mutex);
+    d_ptr->visible = visible;
+}
+
+bool lite_source::visible()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->transform_mutex);
+    return d_ptr->visible;
+}
+
+void lite_source::set_volume(float volume)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    d_ptr->user_volume = volume;
+}
+
+float lite_source::volume()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    return d_ptr->user_volume;
+}
+
+void lite_source::set_balance_value(float balance)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    d_ptr->balance = balance < 0.0f ? 0.0f : (balance > 1.0f ? 1.0f : balance);
+}
 
-    for (size_t mix = 0; mix < MAX_AUDIO_MIXES; mix++) {
-        size_t mix_pos = mix * AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS;
+float lite_source::balance_value()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    return d_ptr->balance;
+}
+
+void lite_source::set_muted(bool muted)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    d_ptr->user_muted = muted;
+}
+
+bool lite_source::muted()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    return d_ptr->user_muted;
+}
+
+void lite_source::set_audio_mixers(uint32_t mixers)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    d_ptr->audio_mixers = mixers;
+}
+
+uint32_t lite_source::audio_mixers()
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+    return d_ptr->audio_mixers;
+}
+
+void lite_source::audio_render(size_t channels, uint32_t frames)
+{
+    size_t size = frames * sizeof(float);
+
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+
+    d_ptr->render_ts = d_ptr->audio_ts;
+    d_ptr->render_mixers = 0;
+    d_ptr->audio_pending = !d_ptr->audio_ts ||
+            d_ptr->audio_input_buf[0].size < size;
+    if (d_ptr->audio_pending)
+        return;
+
+    if (!d_ptr->enabled || !d_ptr->audio_active || d_ptr->user_muted ||
+            d_ptr->muted || !d_ptr->audio_mixers)
+        return;
+
+    /* only sources that reach a mix need an output block */
+    if (d_ptr->audio_output_data.size() != channels * frames)
+        allocate_audio_output_buffer(channels, frames);
+
+    /* every mix takes the same samples, volume and balance are applied
+     * while mixing so one copy of the block is enough */
+    for (size_t i = 0; i < channels; i++)
+        circlebuf_peek_front(&d_ptr->audio_input_buf[i],
+                             d_ptr->audio_output_buf[i], size);
+
+    float vol = d_ptr->user_volume * d_ptr->volume;
+    for (size_t i = 0; i < channels; i++)
+        d_ptr->render_gain[i] = vol;
+
+    if (channels == 2) {
+        float bal = d_ptr->balance;
+        d_ptr->render_gain[0] *= bal > 0.5f ? (1.0f - bal) * 2.0f : 1.0f;
+        d_ptr->render_gain[1] *= bal < 0.5f ? bal * 2.0f : 1.0f;
+    }
 
-        for (size_t i = 0; i < MAX_AUDIO_CHANNELS; i++) {
-            d_ptr->audio_output_buf[mix][i] =
-                    ptr + mix_pos + AUDIO_OUTPUT_FRAMES * i;
+    d_ptr->render_mixers = d_ptr->audio_mixers;
+}
+
+bool lite_source::audio_rendered(uint64_t *ts, uint32_t *mixers)
+{
+    *ts = d_ptr->render_ts;
+    *mixers = d_ptr->render_mixers;
+    return !d_ptr->audio_pending;
+}
+
+void lite_source::audio_mix(audio_output_data *mixes, uint32_t mixers, uint32_t clamp_mixers,
+                            size_t channels, size_t sample_rate, uint32_t frames, uint64_t start_ts)
+{
+    size_t start_point = 0;
+
+    if (d_ptr->render_ts > start_ts)
+        start_point = convert_time_to_frames(sample_rate, d_ptr->render_ts - start_ts);
+    if (start_point >= frames)
+        start_point = frames;
+
+    size_t count = frames - start_point;
+
+    for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
+        if ((mixers & (1 << mix_idx)) == 0)
+            continue;
+
+        bool clamp = (clamp_mixers & (1 << mix_idx)) != 0;
+
+        for (size_t ch = 0; ch < channels; ch++) {
+            float *mix = mixes[mix_idx].data[ch];
+            const float *src = d_ptr->audio_output_buf[ch];
+            float gain = d_ptr->render_gain[ch];
+
+            /* a source starting past this block still clamps the mixes
+             * it was chosen to clamp */
+            if (clamp) {
+                audio_clamp_samples(mix, start_point);
+                audio_mix_clamp_samples(mix + start_point, src, gain, count);
+            } else {
+                audio_mix_samples(mix + start_point, src, gain, count);
+            }
         }
     }
 }
+
+void lite_source::audio_discard(size_t channels, size_t sample_rate, uint32_t frames,
+                                uint64_t start_ts, uint64_t end_ts)
+{
+    std::lock_guard<std::mutex> lock(d_ptr->audio_buf_mutex);
+
+    /* nothing of this block was rendered, or the source restarted its
+     * timeline since then */
+    if (d_ptr->audio_pending || d_ptr->audio_ts != d_ptr->render_ts)
+        return;
+    if (end_ts <= d_ptr->audio_ts)
+        return;
+
+    size_t drop = frames;
+    if (d_ptr->audio_ts > start_ts)
+        drop -= convert_time_to_frames(sample_rate, d_ptr->audio_ts - start_ts);
+    else if (d_ptr->audio_ts + 1 < start_ts)
+        /* later than audio buffering can make up for, drop the stale
+         * samples too */
+        drop += convert_time_to_frames(sample_rate, start_ts - d_ptr->audio_ts);
+
+    size_t size = drop * sizeof(float);
+    if (size > d_ptr->audio_input_buf[0].size)
+        size = d_ptr->audio_input_buf[0].size;
+
+    for (size_t i = 0; i < channels; i++)
+        circlebuf_pop_front(&d_ptr->audio_input_buf[i], NULL, size);
+
+    d_ptr->audio_ts = end_ts;
+}
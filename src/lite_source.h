@@ -3,6 +3,8 @@
 #include <memory>
 #include <string>
 #include "media-io/audio_output.h"
+#include "media-io/video_info.h"
+#include <glm/vec2.hpp>
 
 enum class obs_source_type {
     OBS_SOURCE_TYPE_INPUT,
@@ -59,6 +61,15 @@ enum class obs_source_type {
  */
 #define OBS_SOURCE_CUSTOM_DRAW (1 << 3)
 
+/**
+ * Source video has no transparent pixels.
+ *
+ * Frames in formats with an alpha channel are then treated as opaque too, so
+ * layers the source fully covers can be skipped when compositing.  Formats
+ * without alpha are always opaque.
+ */
+#define OBS_SOURCE_OPAQUE (1 << 4)
+
 
 class lite_source;
 class lite_source_impl
@@ -66,9 +77,9 @@ class lite_source_impl
 public:
     std::string id;
 
-    obs_source_type type;
+    obs_source_type type{};
 
-    uint32_t output_flags;
+    uint32_t output_flags{};
 
     uint32_t get_width()
     {
@@ -102,17 +113,116 @@ public:
 
 };
 
+/**
+ * Raw audio passed to lite_source::output_audio.  Data that is not in the
+ * audio output's format is resampled before it is buffered.
+ */
+struct obs_source_audio {
+    const uint8_t *data[MAX_AV_PLANES]{};
+    uint32_t frames{};
+
+    speaker_layout speakers = speaker_layout::SPEAKERS_UNKNOWN;
+    audio_format format = audio_format::AUDIO_FORMAT_UNKNOWN;
+    uint32_t samples_per_sec{};
+
+    uint64_t timestamp{};
+};
+
+/**
+ * Raw video passed to lite_source::output_video.  The planes are copied into
+ * the source's frame queue, the graphics thread uploads the frame closest to
+ * each render time and converts it to RGB on the GPU.
+ */
+struct obs_source_frame {
+    const uint8_t *data[MAX_AV_PLANES]{};
+    uint32_t linesize[MAX_AV_PLANES]{};
+    uint32_t width{};
+    uint32_t height{};
+    uint64_t timestamp{};
+
+    video_format format = video_format::VIDEO_FORMAT_NONE;
+    video_colorspace colorspace = video_colorspace::VIDEO_CS_DEFAULT;
+    video_range_type range = video_range_type::VIDEO_RANGE_DEFAULT;
+    bool flip{};
+};
+
+/**
+ * Placement of a source's video on the canvas.  The video is scaled, rotated
+ * clockwise by rot degrees around its top left corner and then moved to pos.
+ * A non-zero bounds stretches the video to that size and ignores scale.
+ */
+struct obs_transform_info {
+    glm::vec2 pos{};
+    float rot{};
+    glm::vec2 scale{1.0f, 1.0f};
+    glm::vec2 bounds{};
+};
+
+struct async_frame;
 struct lite_source_private;
+class graphics_subsystem;
 class lite_source : public std::enable_shared_from_this<lite_source>
 {
 public:
-    lite_source(const std::string &id);
+    lite_source(const std::string &id, uint32_t output_flags);
     ~lite_source();
 
     bool is_audio_source();
+    bool is_async_video_source();
+
+    void output_audio(const obs_source_audio *audio);
+
+    /* any thread, frames are queued up to MAX_ASYNC_FRAMES and the oldest
+     * is dropped when the graphics thread falls behind */
+    void output_video(const obs_source_frame *frame);
+
+    /* sources are composited in creation order, later ones on top */
+    void set_transform(const obs_transform_info &info);
+    obs_transform_info transform();
+    void set_visible(bool visible);
+    bool visible();
+
+    /* graphics thread only, picks and converts the frame for render_ts */
+    void async_video_tick(uint64_t render_ts);
+    /* graphics thread only, adds the current frame to the open sprite batch */
+    void video_render(graphics_subsystem *graphics);
+    /* changes whenever what video_render draws changes, a new frame or a
+     * new transform.  Serials are unique across sources */
+    uint64_t video_serial();
+    /* graphics thread only, canvas area the next tick may draw to, sized
+     * for the current and every queued frame */
+    bool video_bounds(glm::vec2 *min, glm::vec2 *max);
+    /* graphics thread only, canvas area the current frame covers with opaque
+     * pixels, false when it may be transparent or is not axis aligned */
+    bool video_opaque_bounds(glm::vec2 *min, glm::vec2 *max);
+
+    void set_volume(float volume);
+    float volume();
+    /* 0.0 is full left, 0.5 center and 1.0 full right (stereo only) */
+    void set_balance_value(float balance);
+    float balance_value();
+    void set_muted(bool muted);
+    bool muted();
+    void set_audio_mixers(uint32_t mixers);
+    uint32_t audio_mixers();
+
+    /* audio thread only, called once per tick in this order */
+    void audio_render(size_t channels, uint32_t frames);
+    bool audio_rendered(uint64_t *ts, uint32_t *mixers);
+    void audio_mix(audio_output_data *mixes, uint32_t mixers, uint32_t clamp_mixers,
+                   size_t channels, size_t sample_rate, uint32_t frames, uint64_t start_ts);
+    void audio_discard(size_t channels, size_t sample_rate, uint32_t frames,
+                       uint64_t start_ts, uint64_t end_ts);
 
 private:
-    void allocate_audio_output_buffer();
+    void allocate_audio_output_buffer(size_t channels, uint32_t frames);
+    bool reset_resampler(const obs_source_audio *audio, const audio_output_info *aoi);
+
+    std::unique_ptr<async_frame> cache_async_frame(const obs_source_frame *frame);
+    bool ready_async_frame(uint64_t render_ts);
+    bool init_async_textures();
+    bool update_async_textures();
+    void free_async_textures();
 
 private:
     std::unique_ptr<lite_source_private> d_ptr{};
@@ -120,5 +230,5 @@ private:
 
 typedef void (*obs_source_audio_capture)(void *param, std::shared_ptr<lite_source> source, const audio_data *audio_data, bool muted);
 
-std::shared_ptr<lite_source> obs_source_create(const std::string &id);
+std::shared_ptr<lite_source> obs_source_create(const std::string &id, uint32_t output_flags = 0);
 void obs_source_destroy(std::shared_ptr<lite_source> source);
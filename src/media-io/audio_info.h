@@ -1,11 +1,13 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 #include "util/util_uint128.h"
 
 #define MAX_AUDIO_MIXES 6
 #define MAX_AUDIO_CHANNELS 8
 #define AUDIO_OUTPUT_FRAMES 1024
+#define MAX_AUDIO_OUTPUT_FRAMES 4096
 
 #define TOTAL_AUDIO_SIZE                                              \
     (MAX_AUDIO_MIXES * MAX_AUDIO_CHANNELS * AUDIO_OUTPUT_FRAMES * \
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <stddef.h>
+
+/* the kernels below run once per source and mix every audio tick, so they
+ * are vectorized: avx when the build targets it, sse2 (always available on
+ * x86-64) or neon otherwise, with a scalar loop for the remainder */
+#if defined(__AVX__)
+#include <immintrin.h>
+#define AUDIO_MATH_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define AUDIO_MATH_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define AUDIO_MATH_NEON
+#endif
+
+static inline float audio_clamp_sample(float val)
+{
+    val = (val > 1.0f) ? 1.0f : val;
+    val = (val < -1.0f) ? -1.0f : val;
+    return val;
+}
+
+static inline void audio_clamp_samples(float *data, size_t count)
+{
+    size_t i = 0;
+
+#if defined(AUDIO_MATH_AVX)
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 val = _mm256_loadu_ps(data + i);
+        _mm256_storeu_ps(data + i, _mm256_max_ps(_mm256_min_ps(val, hi), lo));
+    }
+#elif defined(AUDIO_MATH_SSE2)
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 val = _mm_loadu_ps(data + i);
+        _mm_storeu_ps(data + i, _mm_max_ps(_mm_min_ps(val, hi), lo));
+    }
+#elif defined(AUDIO_MATH_NEON)
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t val = vld1q_f32(data + i);
+        vst1q_f32(data + i, vmaxq_f32(vminq_f32(val, hi), lo));
+    }
+#endif
+
+    for (; i < count; i++)
+        data[i] = audio_clamp_sample(data[i]);
+}
+
+/* dst += src * gain */
+static inline void audio_mix_samples(float *dst, const float *src, float gain, size_t count)
+{
+    size_t i = 0;
+
+#if defined(AUDIO_MATH_AVX)
+    const __m256 mul = _mm256_set1_ps(gain);
+    for (; i + 8 <= count; i += 8) {
+        __m256 val = _mm256_mul_ps(_mm256_loadu_ps(src + i), mul);
+        _mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), val));
+    }
+#elif defined(AUDIO_MATH_SSE2)
+    const __m128 mul = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4) {
+        __m128 val = _mm_mul_ps(_mm_loadu_ps(src + i), mul);
+        _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), val));
+    }
+#elif defined(AUDIO_MATH_NEON)
+    for (; i + 4 <= count; i += 4)
+        vst1q_f32(dst + i, vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain));
+#endif
+
+    for (; i < count; i++)
+        dst[i] += src[i] * gain;
+}
+
+/* dst = clamp(dst + src * gain), for the last source mixed into a buffer so
+ * the mix needs no separate clamp pass */
+static inline void audio_mix_clamp_samples(float *dst, const float *src, float gain, size_t count)
+{
+    size_t i = 0;
+
+#if defined(AUDIO_MATH_AVX)
+    const __m256 mul = _mm256_set1_ps(gain);
+    const __m256 hi = _mm256_set1_ps(1.0f);
+    const __m256 lo = _mm256_set1_ps(-1.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 val = _mm256_mul_ps(_mm256_loadu_ps(src + i), mul);
+        val = _mm256_add_ps(_mm256_loadu_ps(dst + i), val);
+        _mm256_storeu_ps(dst + i, _mm256_max_ps(_mm256_min_ps(val, hi), lo));
+    }
+#elif defined(AUDIO_MATH_SSE2)
+    const __m128 mul = _mm_set1_ps(gain);
+    const __m128 hi = _mm_set1_ps(1.0f);
+    const __m128 lo = _mm_set1_ps(-1.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 val = _mm_mul_ps(_mm_loadu_ps(src + i), mul);
+        val = _mm_add_ps(_mm_loadu_ps(dst + i), val);
+        _mm_storeu_ps(dst + i, _mm_max_ps(_mm_min_ps(val, hi), lo));
+    }
+#elif defined(AUDIO_MATH_NEON)
+    const float32x4_t hi = vdupq_n_f32(1.0f);
+    const float32x4_t lo = vdupq_n_f32(-1.0f);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t val = vmlaq_n_f32(vld1q_f32(dst + i), vld1q_f32(src + i), gain);
+        vst1q_f32(dst + i, vmaxq_f32(vminq_f32(val, hi), lo));
+    }
+#endif
+
+    for (; i < count; i++)
+        dst[i] = audio_clamp_sample(dst[i] + src[i] * gain);
+}
@@ -2,13 +2,18 @@
 
 #include "util/threading.h"
 #include "util/log.h"
+#include "util/trace.h"
+#include "util/stats.h"
 
 #include "audio_resampler.h"
+#include "audio_math.h"
 
 #include <thread>
 #include <mutex>
+#include <atomic>
 #include <vector>
 #include <memory>
+#include <string.h>
 
 class audio_input {
 public:
@@ -51,12 +56,17 @@ public:
 
 struct audio_mix {
     std::vector<std::shared_ptr<audio_input>> inputs;
-    float buffer[MAX_AUDIO_CHANNELS][AUDIO_OUTPUT_FRAMES]{};
+
+    /* a plane of frames_per_block floats per channel, allocated when the
+     * first input connects to the mix and kept until the output closes */
+    std::vector<float> samples;
+    float *buffer[MAX_AUDIO_CHANNELS]{};
 };
 
 struct audio_output_private {
     audio_output_info info{};
     size_t block_size{};
+    uint32_t frames{};
     size_t channels{};
     size_t planes{};
 
@@ -69,6 +79,9 @@ struct audio_output_private {
     void *input_param{};
     std::recursive_mutex input_mutex;
     audio_mix mixes[MAX_AUDIO_MIXES]{};
+
+    stats_histogram tick_jitter{};
+    std::atomic<uint32_t> overruns{};
 };
 
 audio_output::audio_output()
@@ -84,10 +97,11 @@ audio_output::~audio_output()
 static inline bool valid_audio_params(const audio_output_info *info)
 {
     return info->format != audio_format::AUDIO_FORMAT_UNKNOWN && info->name && info->samples_per_sec > 0 &&
-            info->speakers != speaker_layout::SPEAKERS_UNKNOWN;
+            info->speakers != speaker_layout::SPEAKERS_UNKNOWN &&
+            info->frames_per_block <= MAX_AUDIO_OUTPUT_FRAMES;
 }
 
-void audio_output::clamp_audio_output(size_t bytes)
+void audio_output::clamp_audio_output(uint32_t active_mixes, size_t bytes)
 {
     size_t float_size = bytes / sizeof(float);
 
@@ -95,19 +109,11 @@ void audio_output::clamp_audio_output(size_t bytes)
         audio_mix *mix = &d_ptr->mixes[mix_idx];
 
         /* do not process mixing if a specific mix is inactive */
-        if (!mix->inputs.size())
+        if ((active_mixes & (1 << mix_idx)) == 0)
             continue;
 
         for (size_t plane = 0; plane < d_ptr->planes; plane++) {
-            float *mix_data = mix->buffer[plane];
-            float *mix_end = &mix_data[float_size];
-
-            while (mix_data < mix_end) {
-                float val = *mix_data;
-                val = (val > 1.0f) ? 1.0f : val;
-                val = (val < -1.0f) ? -1.0f : val;
-                *(mix_data++) = val;
-            }
+            audio_clamp_samples(mix->buffer[plane], float_size);
         }
     }
 }
@@ -157,7 +163,8 @@ void audio_output::do_audio_output(size_t mix_idx, uint64_t timestamp, uint32_t
 
 void audio_output::input_and_output(uint64_t audio_time, uint64_t prev_time)
 {
-    size_t bytes = AUDIO_OUTPUT_FRAMES * d_ptr->block_size;
+    TRACE_SCOPE("audio_input_and_output");
+    size_t bytes = d_ptr->frames * d_ptr->block_size;
     audio_output_data data[MAX_AUDIO_MIXES];
     uint32_t active_mixes = 0;
     uint64_t new_ts = 0;
@@ -178,13 +185,14 @@ void audio_output::input_and_output(uint64_t audio_time, uint64_t prev_time)
     }
     d_ptr->input_mutex.unlock();
 
-    /* clear mix buffers */
+    /* clear mix buffers, inactive mixes are left unallocated and untouched */
     for (size_t mix_idx = 0; mix_idx < MAX_AUDIO_MIXES; mix_idx++) {
         audio_mix *mix = &d_ptr->mixes[mix_idx];
 
-        memset(mix->buffer[0], 0,
-                AUDIO_OUTPUT_FRAMES * MAX_AUDIO_CHANNELS *
-                sizeof(float));
+        if ((active_mixes & (1 << mix_idx)) == 0)
+            continue;
+
+        memset(mix->buffer[0], 0, mix->samples.size() * sizeof(float));
 
         for (size_t i = 0; i < d_ptr->planes; i++)
             data[mix_idx].data[i] = mix->buffer[i];
@@ -199,11 +207,14 @@ void audio_output::input_and_output(uint64_t audio_time, uint64_t prev_time)
         return;
 
     /* clamps audio data to -1.0..1.0 */
-    clamp_audio_output(bytes);
+    if (!d_ptr->info.input_clamped)
+        clamp_audio_output(active_mixes, bytes);
 
     /* output */
-    for (size_t i = 0; i < MAX_AUDIO_MIXES; i++)
-        do_audio_output(i, new_ts, AUDIO_OUTPUT_FRAMES);
+    for (size_t i = 0; i < MAX_AUDIO_MIXES; i++) {
+        if (active_mixes & (1 << i))
+            do_audio_output(i, new_ts, d_ptr->frames);
+    }
 }
 
 void audio_output::audio_thread_internal()
@@ -213,29 +224,32 @@ void audio_output::audio_thread_internal()
     uint64_t start_time = os_gettime_ns();
     uint64_t prev_time = start_time;
     uint64_t audio_time = prev_time;
-    uint32_t audio_wait_time = (uint32_t)(
-                audio_frames_to_ns(rate, AUDIO_OUTPUT_FRAMES) / 1000000);
-
+    uint32_t frames = d_ptr->frames;
+    uint64_t block_ns = audio_frames_to_ns(rate, frames);
 
+    /* one tick per block boundary, the deadline comes from the sample
+     * count so it never drifts.  a tick that misses the next boundary
+     * as well is an overrun, the ticks owed are then issued back to back
+     * to keep the timeline gapless */
     while (os_event_try(d_ptr->stop_event) == EAGAIN) {
-        uint64_t cur_time;
+        os_sleepto_ns(audio_time);
 
-        os_sleep_ms(audio_wait_time);
+        uint64_t late = os_gettime_ns() - audio_time;
+        d_ptr->tick_jitter.record(late);
+        if (late >= block_ns)
+            d_ptr->overruns++;
 
-        cur_time = os_gettime_ns();
-        while (audio_time <= cur_time) {
-            samples += AUDIO_OUTPUT_FRAMES;
-            audio_time =
-                    start_time + audio_frames_to_ns(rate, samples);
+        samples += frames;
+        audio_time = start_time + audio_frames_to_ns(rate, samples);
 
-            input_and_output(audio_time, prev_time);
-            prev_time = audio_time;
-        }
+        input_and_output(audio_time, prev_time);
+        prev_time = audio_time;
     }
 }
 
 void audio_output::audio_thread(void *param)
 {
+    TRACE_THREAD_NAME("audio_output");
     audio_output *audio = (audio_output *)param;
     audio->audio_thread_internal();
 }
@@ -257,6 +271,8 @@ int audio_output::audio_output_open(audio_output_info *info)
     d_ptr->input_param = info->input_param;
     d_ptr->block_size = (planar ? 1 : d_ptr->channels) *
             get_audio_bytes_per_channel(info->format);
+    d_ptr->frames = info->frames_per_block ? info->frames_per_block : AUDIO_OUTPUT_FRAMES;
+    d_ptr->info.frames_per_block = d_ptr->frames;
 
     if (os_event_init(&d_ptr->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
         goto fail;
@@ -335,8 +351,15 @@ bool audio_output::audio_output_connect(size_t mix_idx,
             input->conversion.samples_per_sec = d_ptr->info.samples_per_sec;
 
         success = input->audio_input_init(&d_ptr->info);
-        if (success)
+        if (success) {
+            if (mix->samples.empty()) {
+                mix->samples.assign((size_t)d_ptr->frames * d_ptr->channels, 0.0f);
+                for (size_t i = 0; i < d_ptr->channels; i++)
+                    mix->buffer[i] = mix->samples.data() + i * d_ptr->frames;
+            }
+
             mix->inputs.push_back(std::move(input));
+        }
     }
 
     return success;
@@ -357,6 +380,15 @@ void audio_output::audio_output_disconnect(size_t mix_idx,
     }
 }
 
+void audio_output::audio_output_get_tick_stats(stats_histogram_snapshot *jitter, uint32_t *overruns, bool reset)
+{
+    if (!d_ptr)
+        return;
+
+    d_ptr->tick_jitter.snapshot(jitter, reset);
+    *overruns = d_ptr->overruns;
+}
+
 bool audio_output::audio_output_active()
 {
     if (!d_ptr)
@@ -377,6 +409,11 @@ size_t audio_output::audio_output_get_block_size()
     return d_ptr ? d_ptr->block_size : 0;
 }
 
+uint32_t audio_output::audio_output_get_frames_per_block()
+{
+    return d_ptr ? d_ptr->frames : 0;
+}
+
 size_t audio_output::audio_output_get_planes()
 {
     return d_ptr ? d_ptr->planes : 0;
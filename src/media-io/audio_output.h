@@ -29,8 +29,15 @@ struct audio_output_info {
     audio_format format = audio_format::AUDIO_FORMAT_UNKNOWN;
     speaker_layout speakers = speaker_layout::SPEAKERS_UNKNOWN;
 
+    /** Frames mixed per tick (0 = AUDIO_OUTPUT_FRAMES, max
+     *  MAX_AUDIO_OUTPUT_FRAMES) */
+    uint32_t frames_per_block{};
+
     audio_input_callback_t input_callback{};
     void *input_param{};
+
+    /** The input callback leaves its mixes within -1..1, skip the clamp */
+    bool input_clamped{};
 };
 
 struct audio_convert_info {
@@ -45,6 +52,7 @@ struct audio_convert_info {
 
 class audio_input;
 struct audio_output_private;
+struct stats_histogram_snapshot;
 class audio_output
 {
 public:
@@ -66,7 +74,12 @@ public:
 
     bool audio_output_active();
 
+    /* jitter is how late each tick started after its block boundary,
+     * overruns count ticks that started after the following one was due */
+    void audio_output_get_tick_stats(stats_histogram_snapshot *jitter, uint32_t *overruns, bool reset);
+
     size_t audio_output_get_block_size();
+    uint32_t audio_output_get_frames_per_block();
     size_t audio_output_get_planes();
     size_t audio_output_get_channels();
     uint32_t audio_output_get_sample_rate();
@@ -75,7 +88,7 @@ public:
 private:
     int get_input_index(size_t mix_idx, audio_output_callback_t callback, void *param);
     void input_and_output(uint64_t audio_time, uint64_t prev_time);
-    void clamp_audio_output(size_t bytes);
+    void clamp_audio_output(uint32_t active_mixes, size_t bytes);
     void do_audio_output(size_t mix_idx, uint64_t timestamp, uint32_t frames);
     bool resample_audio_output(std::shared_ptr<audio_input> input, audio_data *data);
 
@@ -1,5 +1,6 @@
 #include "video-matrices.h"
 #include <memory>
+#include <string.h>
 
 static struct {
     video_colorspace const color_space;
@@ -1,20 +1,23 @@
 #include "video_frame.h"
+#include <string.h>
 
 #define ALIGN_SIZE(size, align) size = (((size) + (align - 1)) & (~(align - 1)))
 
-video_frame::video_frame()
+video_frame_buffer::video_frame_buffer()
 {
-    data.resize(8);
 }
 
-video_frame::~video_frame()
+video_frame_buffer::~video_frame_buffer()
 {
 
 }
 
-void video_frame::video_frame_init(video_format format, uint32_t width, uint32_t height)
+void video_frame_buffer::video_frame_buffer_init(video_format format, uint32_t width, uint32_t height)
 {
-    data.resize(MAX_AV_PLANES);
+    auto data = view.data;
+    auto linesize = view.linesize;
+
+    video_frame_buffer_free();
 
     size_t size;
     size_t offsets[MAX_AV_PLANES];
@@ -195,11 +198,11 @@ void video_frame::video_frame_init(video_format format, uint32_t width, uint32_t
     }
 }
 
-void video_frame::video_frame_free()
+void video_frame_buffer::video_frame_buffer_free()
 {
-    data_internal.clear();
-    data.clear();
-    memset(linesize, 0, sizeof(linesize));
+    std::vector<uint8_t>().swap(data_internal);
+    memset(view.data, 0, sizeof(view.data));
+    memset(view.linesize, 0, sizeof(view.linesize));
 }
 
 void video_frame::video_frame_copy(video_frame *dst, const video_frame *src, video_format format, uint32_t cy)
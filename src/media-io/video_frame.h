@@ -6,20 +6,32 @@
 #include <memory>
 #include <vector>
 
+/* non-owning plane pointers/linesizes, cheap to copy */
 class video_frame
 {
 public:
-    video_frame();
-    ~video_frame();
-
-    void video_frame_init(video_format format, uint32_t width, uint32_t height);
-    void video_frame_free();
-
     static void video_frame_copy(video_frame *dst, const video_frame *src, video_format format, uint32_t cy);
 
-    std::vector<uint8_t *> data;
+    uint8_t *data[MAX_AV_PLANES]{};
     uint32_t linesize[MAX_AV_PLANES]{};
+};
+
+/* owns the plane memory, hands out a video_frame view of it */
+class video_frame_buffer
+{
+public:
+    video_frame_buffer();
+    ~video_frame_buffer();
+
+    video_frame_buffer(const video_frame_buffer &) = delete;
+    video_frame_buffer &operator=(const video_frame_buffer &) = delete;
+
+    void video_frame_buffer_init(video_format format, uint32_t width, uint32_t height);
+    void video_frame_buffer_free();
+
+    const video_frame &frame() const { return view; }
 
 private:
+    video_frame view{};
     std::vector<uint8_t> data_internal;
 };
@@ -3,14 +3,17 @@
 #include "video_frame.h"
 #include "util/threading.h"
 #include "util/log.h"
+#include "util/trace.h"
 #include <thread>
 #include <mutex>
 #include <vector>
+#include <string.h>
 
 #define MAX_CONVERT_BUFFERS 3
 #define MAX_CACHE_SIZE 16
 
 struct cached_frame_info {
+    video_frame_buffer buffer{};
     struct video_data frame{};
     int skipped{};
     int count{};
@@ -20,7 +23,7 @@ struct video_input
 {
     struct video_scale_info conversion{};
     std::unique_ptr<video_scaler> scaler{};
-    video_frame frame[MAX_CONVERT_BUFFERS]{};
+    video_frame_buffer frame[MAX_CONVERT_BUFFERS]{};
     int cur_frame{};
 
     void (*callback)(void *param, struct video_data *frame){};
@@ -45,7 +48,8 @@ struct video_output_private
     std::recursive_mutex input_mutex;
     std::vector<std::shared_ptr<video_input>> inputs{};
 
-    size_t available_frames{};
+    /* written under data_mutex, atomic so stats can read it without it */
+    std::atomic<size_t> available_frames{};
     size_t first_added{};
     size_t last_added{};
     cached_frame_info cache[MAX_CACHE_SIZE]{};
@@ -65,6 +69,7 @@ video_output::~video_output()
 
 void video_output::video_thread(void *arg)
 {
+    TRACE_THREAD_NAME("video_output");
     video_output *out = (video_output *)arg;
     out->video_thread_internal();
 }
@@ -101,8 +106,9 @@ void video_output::video_output_close()
     d_ptr->inputs.clear();
 
     for (size_t i = 0; i < d_ptr->info.cache_size; i++) {
-        auto frame = &d_ptr->cache[i].frame;
-        frame->frame.video_frame_free();
+        auto cfi = &d_ptr->cache[i];
+        cfi->buffer.video_frame_buffer_free();
+        cfi->frame.frame = cfi->buffer.frame();
     }
 
     os_sem_destroy(d_ptr->update_semaphore);
@@ -250,6 +256,16 @@ uint32_t video_output::video_output_get_total_frames()
     return d_ptr->total_frames;
 }
 
+uint32_t video_output::video_output_get_skipped_frames()
+{
+    return d_ptr->skipped_frames;
+}
+
+uint32_t video_output::video_output_get_cached_frames()
+{
+    return (uint32_t)(d_ptr->info.cache_size - d_ptr->available_frames);
+}
+
 void video_output::video_thread_internal()
 {
     while (os_sem_wait(d_ptr->update_semaphore) == 0) {
@@ -266,6 +282,7 @@ void video_output::video_thread_internal()
 
 bool video_output::video_output_cur_frame()
 {
+    TRACE_SCOPE("video_output_cur_frame");
     bool complete;
     bool skipped;
 
@@ -283,7 +300,7 @@ bool video_output::video_output_cur_frame()
 
     for (size_t i = 0; i < d_ptr->inputs.size(); i++) {
         auto input = d_ptr->inputs[i];
-        auto frame = frame_info->frame;
+        video_data frame = frame_info->frame;
 
         if (scale_video_output(input, &frame))
             input->callback(input->param, &frame);
@@ -323,8 +340,9 @@ void video_output::init_cache()
         d_ptr->info.cache_size = MAX_CACHE_SIZE;
 
     for (size_t i = 0; i < d_ptr->info.cache_size; i++) {
-        auto frame = &d_ptr->cache[i].frame;
-        frame->frame.video_frame_init(d_ptr->info.format, d_ptr->info.width, d_ptr->info.height);
+        auto cfi = &d_ptr->cache[i];
+        cfi->buffer.video_frame_buffer_init(d_ptr->info.format, d_ptr->info.width, d_ptr->info.height);
+        cfi->frame.frame = cfi->buffer.frame();
     }
 
     d_ptr->available_frames = d_ptr->info.cache_size;
@@ -367,7 +385,7 @@ bool video_output::video_input_init(std::shared_ptr<video_input> input)
         }
 
         for (size_t i = 0; i < MAX_CONVERT_BUFFERS; i++)
-            input->frame[i].video_frame_init(input->conversion.format, input->conversion.width, input->conversion.height);
+            input->frame[i].video_frame_buffer_init(input->conversion.format, input->conversion.width, input->conversion.height);
     }
 
     return true;
@@ -398,23 +416,19 @@ void video_output::log_skipped()
 
 bool video_output::scale_video_output(std::shared_ptr<video_input> input, video_data *data)
 {
+    TRACE_SCOPE("scale_video_output");
     bool success = true;
 
     if (input->scaler) {
-        video_frame *frame;
-
         if (++input->cur_frame == MAX_CONVERT_BUFFERS)
             input->cur_frame = 0;
 
-        frame = &input->frame[input->cur_frame];
+        const video_frame &frame = input->frame[input->cur_frame].frame();
 
-        success = input->scaler->video_scaler_scale(frame->data.data(), frame->linesize, (const uint8_t *const *)data->frame.data.data(), data->frame.linesize);
+        success = input->scaler->video_scaler_scale((uint8_t **)frame.data, frame.linesize, (const uint8_t *const *)data->frame.data, data->frame.linesize);
 
         if (success) {
-            for (size_t i = 0; i < MAX_AV_PLANES; i++) {
-                data->frame.data[i] = frame->data[i];
-                data->frame.linesize[i] = frame->linesize[i];
-            }
+            data->frame = frame;
         } else {
             blog(LOG_WARNING, "video-io: Could not scale frame!");
         }
@@ -57,6 +57,8 @@ public:
 
     uint64_t video_output_get_frame_time();
     uint32_t video_output_get_total_frames();
+    uint32_t video_output_get_skipped_frames();
+    uint32_t video_output_get_cached_frames();
 
 private:
     void video_thread_internal();
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <memory>
+#include <atomic>
+
+/*
+ * shared_ptr that one thread replaces while others read it.  Uses
+ * std::atomic<std::shared_ptr> where the standard library has it, which
+ * only ever contends on the pointer itself.  The fallback (NDK libc++) is
+ * std::atomic_load/atomic_store, which lock one of a small pool of global
+ * mutexes shared with every other pointer accessed that way.
+ */
+template<typename T>
+class atomic_shared_ptr
+{
+public:
+    atomic_shared_ptr() = default;
+    atomic_shared_ptr(std::shared_ptr<T> ptr) : ptr(std::move(ptr)) {}
+    atomic_shared_ptr(const atomic_shared_ptr &) = delete;
+    atomic_shared_ptr &operator=(const atomic_shared_ptr &) = delete;
+
+    std::shared_ptr<T> load() const {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return ptr.load(std::memory_order_acquire);
+#else
+        return std::atomic_load_explicit(&ptr, std::memory_order_acquire);
+#endif
+    }
+
+    void store(std::shared_ptr<T> new_ptr) {
+#ifdef __cpp_lib_atomic_shared_ptr
+        ptr.store(std::move(new_ptr), std::memory_order_release);
+#else
+        std::atomic_store_explicit(&ptr, std::move(new_ptr), std::memory_order_release);
+#endif
+    }
+
+private:
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<T>> ptr;
+#else
+    std::shared_ptr<T> ptr;
+#endif
+};
@@ -0,0 +1,371 @@
+#include "log.h"
+#include "threading.h"
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <semaphore>
+#include <string.h>
+
+#if defined __ANDROID__
+#include <android/log.h>
+#endif
+
+#define LOG_RING_SIZE 512
+#define LOG_RING_MASK (LOG_RING_SIZE - 1)
+#define LOG_MSG_SIZE 1024
+#define LOG_MAX_SINKS 8
+
+#define LOG_RATE_SITES 256
+#define LOG_RATE_PROBES 8
+#define LOG_RATE_WINDOW_NS 1000000000LL
+#define LOG_RATE_BURST 30
+
+static_assert((LOG_RING_SIZE & LOG_RING_MASK) == 0, "LOG_RING_SIZE must be a power of two");
+
+struct log_slot {
+    std::atomic<size_t> seq{};
+    int level{};
+    int64_t timestamp{};
+    char msg[LOG_MSG_SIZE];
+};
+
+struct log_rate_site {
+    std::atomic<const char *> format{};
+    std::atomic<int64_t> window_start{};
+    std::atomic<uint32_t> count{};
+    std::atomic<uint32_t> suppressed{};
+};
+
+struct log_sink_info {
+    log_sink_t sink{};
+    void *param{};
+};
+
+struct log_state {
+#ifdef _DEBUG
+    std::atomic_int level{LOG_DEBUG};
+#else
+    std::atomic_int level{LOG_INFO};
+#endif
+
+    /* bounded MPSC ring, producers claim slots with a CAS on tail and
+     * publish them through the per-slot sequence number */
+    log_slot ring[LOG_RING_SIZE];
+    alignas(64) std::atomic<size_t> tail{};
+    alignas(64) size_t head{};
+    std::atomic<size_t> consumed{};
+    std::atomic<uint64_t> dropped{};
+    uint64_t dropped_reported{};
+
+    log_rate_site sites[LOG_RATE_SITES];
+
+    std::mutex sink_mutex;
+    log_sink_info sinks[LOG_MAX_SINKS];
+
+    std::counting_semaphore<> wakeup{0};
+    std::mutex flush_mutex;
+    std::condition_variable flush_cond;
+
+    std::thread thread;
+    std::atomic_bool stop{};
+    std::atomic_bool running{};
+
+    log_state() {
+        for (size_t i = 0; i < LOG_RING_SIZE; i++)
+            ring[i].seq.store(i, std::memory_order_relaxed);
+
+        sinks[0].sink = blog_default_sink;
+
+        running = true;
+        thread = std::thread(&log_state::thread_func, this);
+    }
+
+    void dispatch(int log_level, int64_t ts, const char *msg) {
+        std::lock_guard<std::mutex> lock(sink_mutex);
+        for (size_t i = 0; i < LOG_MAX_SINKS; i++) {
+            if (sinks[i].sink)
+                sinks[i].sink(log_level, ts, msg, sinks[i].param);
+        }
+    }
+
+    bool drain() {
+        bool any = false;
+
+        for (;;) {
+            log_slot *slot = &ring[head & LOG_RING_MASK];
+            if (slot->seq.load(std::memory_order_acquire) != head + 1)
+                break;
+
+            dispatch(slot->level, slot->timestamp, slot->msg);
+
+            slot->seq.store(head + LOG_RING_SIZE, std::memory_order_release);
+            head++;
+            any = true;
+        }
+
+        uint64_t dropped_now = dropped.load(std::memory_order_relaxed);
+        if (dropped_now != dropped_reported) {
+            char msg[128];
+            snprintf(msg, sizeof(msg), "log ring full, dropped %llu messages",
+                     (unsigned long long)(dropped_now - dropped_reported));
+            dispatch(LOG_WARNING, os_gettime_ns(), msg);
+            dropped_reported = dropped_now;
+        }
+
+        if (any) {
+            std::lock_guard<std::mutex> lock(flush_mutex);
+            consumed.store(head, std::memory_order_release);
+            flush_cond.notify_all();
+        }
+
+        return any;
+    }
+
+    void thread_func() {
+        while (!stop) {
+            wakeup.acquire();
+            drain();
+        }
+        drain();
+    }
+
+    void shutdown() {
+        stop = true;
+        wakeup.release();
+        if (thread.joinable())
+            thread.join();
+        running = false;
+    }
+
+    bool push(int log_level, const char *format, va_list args) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        log_slot *slot;
+
+        for (;;) {
+            slot = &ring[pos & LOG_RING_MASK];
+            size_t seq = slot->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->level = log_level;
+        slot->timestamp = os_gettime_ns();
+        vsnprintf(slot->msg, sizeof(slot->msg), format, args);
+        slot->seq.store(pos + 1, std::memory_order_release);
+
+        wakeup.release();
+        return true;
+    }
+
+    /* returns false if this call site exceeded its budget for the current
+     * window, *suppressed receives the count from the previous window */
+    bool rate_check(const char *format, int64_t now, uint32_t *suppressed) {
+        size_t hash = ((uintptr_t)format >> 3) * 2654435761u;
+        log_rate_site *site = nullptr;
+
+        for (size_t i = 0; i < LOG_RATE_PROBES; i++) {
+            log_rate_site *cur = &sites[(hash + i) % LOG_RATE_SITES];
+            const char *key = cur->format.load(std::memory_order_acquire);
+            if (key == format) {
+                site = cur;
+                break;
+            }
+            if (!key) {
+                const char *expected = nullptr;
+                if (cur->format.compare_exchange_strong(expected, format) || expected == format) {
+                    site = cur;
+                    break;
+                }
+            }
+        }
+
+        /* table full, don't limit */
+        if (!site)
+            return true;
+
+        int64_t start = site->window_start.load(std::memory_order_relaxed);
+        if (now - start >= LOG_RATE_WINDOW_NS &&
+            site->window_start.compare_exchange_strong(start, now)) {
+            site->count.store(0, std::memory_order_relaxed);
+            *suppressed = site->suppressed.exchange(0);
+        }
+
+        if (site->count.fetch_add(1, std::memory_order_relaxed) < LOG_RATE_BURST)
+            return true;
+
+        site->suppressed.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+};
+
+static void log_at_exit();
+
+static log_state *get_log_state()
+{
+    static log_state *state = [] {
+        auto s = new log_state();
+        atexit(log_at_exit);
+        return s;
+    }();
+    return state;
+}
+
+static void log_at_exit()
+{
+    /* the state itself is leaked on purpose so that late blog() calls from
+     * other static destructors still have somewhere to go */
+    get_log_state()->shutdown();
+}
+
+static void log_sync(log_state *state, int log_level, const char *format, va_list args)
+{
+    char out[LOG_MSG_SIZE];
+    vsnprintf(out, sizeof(out), format, args);
+    state->dispatch(log_level, os_gettime_ns(), out);
+}
+
+static void log_push(log_state *state, int log_level, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    if (state->running)
+        state->push(log_level, format, args);
+    else
+        log_sync(state, log_level, format, args);
+    va_end(args);
+}
+
+void blogva(int log_level, const char *format, va_list args)
+{
+    auto state = get_log_state();
+    if (log_level > state->level.load(std::memory_order_relaxed))
+        return;
+
+    uint32_t suppressed = 0;
+    if (!state->rate_check(format, os_gettime_ns(), &suppressed))
+        return;
+
+    if (suppressed)
+        log_push(state, LOG_WARNING, "suppressed %u messages like \"%.64s\"", suppressed, format);
+
+    if (state->running)
+        state->push(log_level, format, args);
+    else
+        log_sync(state, log_level, format, args);
+}
+
+void blog(int log_level, const char *format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    blogva(log_level, format, args);
+    va_end(args);
+}
+
+void blog_set_level(int log_level)
+{
+    get_log_state()->level = log_level;
+}
+
+int blog_get_level()
+{
+    return get_log_state()->level;
+}
+
+bool blog_add_sink(log_sink_t sink, void *param)
+{
+    auto state = get_log_state();
+    std::lock_guard<std::mutex> lock(state->sink_mutex);
+
+    for (size_t i = 0; i < LOG_MAX_SINKS; i++) {
+        if (!state->sinks[i].sink) {
+            state->sinks[i].sink = sink;
+            state->sinks[i].param = param;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void blog_remove_sink(log_sink_t sink, void *param)
+{
+    auto state = get_log_state();
+    std::lock_guard<std::mutex> lock(state->sink_mutex);
+
+    for (size_t i = 0; i < LOG_MAX_SINKS; i++) {
+        if (state->sinks[i].sink == sink && state->sinks[i].param == param) {
+            state->sinks[i].sink = nullptr;
+            state->sinks[i].param = nullptr;
+        }
+    }
+}
+
+void blog_default_sink(int log_level, int64_t timestamp_ns, const char *msg, void *param)
+{
+    (void)timestamp_ns;
+    (void)param;
+
+#if defined __ANDROID__
+    __android_log_print(log_level <= LOG_ERROR ? ANDROID_LOG_ERROR :
+                        log_level <= LOG_WARNING ? ANDROID_LOG_WARN :
+                        log_level <= LOG_INFO ? ANDROID_LOG_INFO : ANDROID_LOG_DEBUG,
+                        "lite-obs", "%s", msg);
+#endif
+
+    switch (log_level) {
+    case LOG_DEBUG:
+        fprintf(stdout, "debug: %s\n", msg);
+        fflush(stdout);
+        break;
+
+    case LOG_INFO:
+        fprintf(stdout, "info: %s\n", msg);
+        fflush(stdout);
+        break;
+
+    case LOG_WARNING:
+        fprintf(stdout, "warning: %s\n", msg);
+        fflush(stdout);
+        break;
+
+    case LOG_ERROR:
+        fprintf(stderr, "error: %s\n", msg);
+        fflush(stderr);
+    }
+}
+
+void blog_flush()
+{
+    auto state = get_log_state();
+    if (!state->running)
+        return;
+
+    size_t target = state->tail.load(std::memory_order_acquire);
+    state->wakeup.release();
+
+    std::unique_lock<std::mutex> lock(state->flush_mutex);
+    while (state->consumed.load(std::memory_order_acquire) < target) {
+        state->flush_cond.wait_for(lock, std::chrono::milliseconds(10));
+        if (!state->running)
+            break;
+    }
+}
+
+uint64_t blog_dropped_count()
+{
+    return get_log_state()->dropped;
+}
@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdarg.h>
+#include <stdint.h>
 
 enum {
     /**
@@ -34,49 +35,27 @@ enum {
     LOG_DEBUG = 400
 };
 
-#ifdef _DEBUG
-static int log_output_level = LOG_DEBUG;
-#else
-static int log_output_level = LOG_INFO;
-#endif
-#include <QDebug>
-static void def_log_handler(int log_level, const char *format, va_list args)
-{
-    char out[4096];
-    vsnprintf(out, sizeof(out), format, args);
+typedef void (*log_sink_t)(int log_level, int64_t timestamp_ns, const char *msg, void *param);
 
-    qDebug() << out;
-    if (log_level <= log_output_level) {
-        switch (log_level) {
-        case LOG_DEBUG:
-            fprintf(stdout, "debug: %s\n", out);
-            fflush(stdout);
-            break;
+/*
+ * blog() only formats the message into a preallocated ring slot and returns,
+ * a background thread hands it to the registered sinks.  Messages logged
+ * from the same call site (same format string) are rate limited, and
+ * messages are dropped (and counted) rather than blocking when the ring is
+ * full.  The default sink writes to stdout/stderr (and logcat on android).
+ */
+void blog(int log_level, const char *format, ...);
+void blogva(int log_level, const char *format, va_list args);
 
-        case LOG_INFO:
-            fprintf(stdout, "info: %s\n", out);
-            fflush(stdout);
-            break;
+void blog_set_level(int log_level);
+int blog_get_level();
 
-        case LOG_WARNING:
-            fprintf(stdout, "warning: %s\n", out);
-            fflush(stdout);
-            break;
+bool blog_add_sink(log_sink_t sink, void *param);
+void blog_remove_sink(log_sink_t sink, void *param);
+void blog_default_sink(int log_level, int64_t timestamp_ns, const char *msg, void *param);
 
-        case LOG_ERROR:
-            fprintf(stderr, "error: %s\n", out);
-            fflush(stderr);
-        }
-    }
-}
-
-static inline void blog(int log_level, const char *format, ...)
-{
-    va_list args;
-
-    va_start(args, format);
-    def_log_handler(log_level, format, args);
-    va_end(args);
-}
+/* blocks until everything logged so far has reached the sinks */
+void blog_flush();
+uint64_t blog_dropped_count();
 
 #endif // LOG_H
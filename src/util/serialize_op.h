@@ -2,6 +2,7 @@
 
 #include <cstddef>
 #include <vector>
+#include <string.h>
 
 class serialize_op
 {
@@ -0,0 +1,61 @@
+#include "stats.h"
+
+uint64_t stats_histogram::bucket_value(size_t idx)
+{
+    if (idx < STATS_HISTOGRAM_SUB_COUNT)
+        return idx;
+
+    uint32_t msb = (uint32_t)(idx / STATS_HISTOGRAM_SUB_COUNT) + STATS_HISTOGRAM_SUB_BITS - 1;
+    uint64_t sub = idx % STATS_HISTOGRAM_SUB_COUNT;
+    uint64_t width = 1ULL << (msb - STATS_HISTOGRAM_SUB_BITS);
+
+    return (1ULL << msb) + sub * width + width / 2;
+}
+
+void stats_histogram::snapshot(stats_histogram_snapshot *out, bool reset)
+{
+    uint64_t counts[STATS_HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+
+    for (size_t i = 0; i < STATS_HISTOGRAM_BUCKETS; i++) {
+        counts[i] = reset ? buckets[i].exchange(0, std::memory_order_relaxed)
+                          : buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+
+    uint64_t s = reset ? sum.exchange(0, std::memory_order_relaxed) : sum.load(std::memory_order_relaxed);
+    uint64_t lo = reset ? min.exchange(UINT64_MAX, std::memory_order_relaxed) : min.load(std::memory_order_relaxed);
+    uint64_t hi = reset ? max.exchange(0, std::memory_order_relaxed) : max.load(std::memory_order_relaxed);
+
+    *out = stats_histogram_snapshot{};
+    out->count = total;
+    if (!total)
+        return;
+
+    out->min_ns = lo == UINT64_MAX ? 0 : lo;
+    out->max_ns = hi;
+    out->mean_ns = s / total;
+
+    struct { uint64_t *value; uint64_t rank; } percentiles[] = {
+        {&out->p50_ns, (total * 500 + 999) / 1000},
+        {&out->p90_ns, (total * 900 + 999) / 1000},
+        {&out->p99_ns, (total * 990 + 999) / 1000},
+        {&out->p999_ns, (total * 999 + 999) / 1000},
+    };
+
+    uint64_t seen = 0;
+    size_t p = 0;
+    for (size_t i = 0; i < STATS_HISTOGRAM_BUCKETS && p < 4; i++) {
+        seen += counts[i];
+        while (p < 4 && seen >= percentiles[p].rank) {
+            uint64_t v = bucket_value(i);
+            /* bucket midpoints can fall outside what was actually seen */
+            if (v > out->max_ns)
+                v = out->max_ns;
+            if (v < out->min_ns)
+                v = out->min_ns;
+            *percentiles[p].value = v;
+            p++;
+        }
+    }
+}
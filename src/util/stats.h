@@ -0,0 +1,85 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/*
+ * Log-linear latency histogram (HDR histogram style): values below
+ * 2^STATS_HISTOGRAM_SUB_BITS get a bucket each, above that every power of
+ * two is split into 2^STATS_HISTOGRAM_SUB_BITS buckets, so the relative
+ * error stays under ~6% from 1ns up to ~68s.  Recording is a handful of
+ * relaxed atomics and safe from any thread; snapshots never block writers.
+ */
+
+#define STATS_HISTOGRAM_SUB_BITS 4
+#define STATS_HISTOGRAM_SUB_COUNT (1 << STATS_HISTOGRAM_SUB_BITS)
+#define STATS_HISTOGRAM_MAX_BITS 36
+#define STATS_HISTOGRAM_BUCKETS ((STATS_HISTOGRAM_MAX_BITS - STATS_HISTOGRAM_SUB_BITS + 2) * STATS_HISTOGRAM_SUB_COUNT)
+
+struct stats_histogram_snapshot {
+    uint64_t count{};
+    uint64_t min_ns{};
+    uint64_t max_ns{};
+    uint64_t mean_ns{};
+    uint64_t p50_ns{};
+    uint64_t p90_ns{};
+    uint64_t p99_ns{};
+    uint64_t p999_ns{};
+};
+
+class stats_histogram
+{
+public:
+    void record(uint64_t value) {
+        buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        uint64_t cur = min.load(std::memory_order_relaxed);
+        while (value < cur && !min.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+            ;
+        cur = max.load(std::memory_order_relaxed);
+        while (value > cur && !max.compare_exchange_weak(cur, value, std::memory_order_relaxed))
+            ;
+    }
+
+    /* reset swaps every bucket out as it is read, so interval snapshots do
+     * not lose samples recorded concurrently */
+    void snapshot(stats_histogram_snapshot *out, bool reset);
+
+    static size_t bucket_index(uint64_t value) {
+        if (value < STATS_HISTOGRAM_SUB_COUNT)
+            return (size_t)value;
+
+        uint32_t msb = highest_bit(value);
+        if (msb > STATS_HISTOGRAM_MAX_BITS)
+            return STATS_HISTOGRAM_BUCKETS - 1;
+
+        uint64_t sub = (value >> (msb - STATS_HISTOGRAM_SUB_BITS)) & (STATS_HISTOGRAM_SUB_COUNT - 1);
+        return (size_t)(msb - STATS_HISTOGRAM_SUB_BITS + 1) * STATS_HISTOGRAM_SUB_COUNT + (size_t)sub;
+    }
+
+    /* midpoint of the range a bucket covers */
+    static uint64_t bucket_value(size_t idx);
+
+private:
+    static uint32_t highest_bit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long idx;
+        _BitScanReverse64(&idx, value);
+        return (uint32_t)idx;
+#else
+        return 63 - (uint32_t)__builtin_clzll(value);
+#endif
+    }
+
+private:
+    std::atomic<uint64_t> buckets[STATS_HISTOGRAM_BUCKETS]{};
+    std::atomic<uint64_t> sum{};
+    std::atomic<uint64_t> min{UINT64_MAX};
+    std::atomic<uint64_t> max{};
+};
@@ -112,11 +112,24 @@ int os_sem_wait(os_sem_t *sem)
     return 0;
 }
 
+#if defined(__ANDROID__) || defined(__linux__)
+#include <time.h>
+
+int64_t os_gettime_ns()
+{
+    /* monotonic, ntp steps of the wall clock must not show up as frame
+     * lag or timestamp jumps.  served from the vdso, no syscall */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#else
 int64_t os_gettime_ns()
 {
-    std::chrono::time_point<std::chrono::system_clock> now = std::chrono::system_clock::now();
+    auto now = std::chrono::steady_clock::now();
     return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
 }
+#endif
 
 void os_sleep_ms(uint32_t duration)
 {
@@ -161,24 +174,63 @@ bool os_sleepto_ns(uint64_t time_target)
 #endif
     }
 }
-#elif defined(__ANDROID__)
+#elif defined(__ANDROID__) || defined(__linux__)
+#include <errno.h>
+#include <sys/prctl.h>
+#include <sched.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+#define SLEEPTO_SPIN_NS 50000ULL
+
+static inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#endif
+}
+
+/* sleeps to shortly before the target on the absolute monotonic clock and
+ * spins at most the last SLEEPTO_SPIN_NS.  a wakeup that comes later than
+ * that is not compensated with more spinning, the caller sees it as
+ * lateness (the graphics thread records it in pacer_jitter) */
 bool os_sleepto_ns(uint64_t time_target)
 {
+    thread_local bool slack_set = false;
+
     uint64_t current = os_gettime_ns();
     if (time_target < current)
         return false;
 
-    time_target -= current;
+    if (!slack_set) {
+        /* the default 50us timer slack alone would eat the spin window */
+        prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+        slack_set = true;
+    }
 
-    struct timespec req, remain;
-    memset(&req, 0, sizeof(req));
-    memset(&remain, 0, sizeof(remain));
-    req.tv_sec = time_target / 1000000000;
-    req.tv_nsec = time_target % 1000000000;
+    if (time_target - current > SLEEPTO_SPIN_NS) {
+        uint64_t wake = time_target - SLEEPTO_SPIN_NS;
+        struct timespec req;
+        req.tv_sec = wake / 1000000000;
+        req.tv_nsec = wake % 1000000000;
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &req, nullptr) == EINTR)
+            ;
+
+        /* an early wakeup gives the cpu away rather than spinning the gap */
+        current = os_gettime_ns();
+        while (current < wake) {
+            sched_yield();
+            current = os_gettime_ns();
+        }
+    }
 
-    while (nanosleep(&req, &remain)) {
-        req = remain;
-        memset(&remain, 0, sizeof(remain));
+    while (current < time_target) {
+        cpu_relax();
+        current = os_gettime_ns();
     }
 
     return true;
@@ -26,8 +26,10 @@ void os_sem_destroy(os_sem_t *sem);
 int os_sem_post(os_sem_t *sem);
 int os_sem_wait(os_sem_t *sem);
 
+/* monotonic clock shared by every pipeline thread and timestamp */
 int64_t os_gettime_ns();
 void os_sleep_ms(uint32_t duration);
+/* returns false without sleeping if time_target already passed */
 bool os_sleepto_ns(uint64_t time_target);
 void os_breakpoint(void);
 
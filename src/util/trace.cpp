@@ -0,0 +1,249 @@
+#include "trace.h"
+#include "log.h"
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string>
+#include <stdio.h>
+
+#define TRACE_RING_SIZE 16384
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+struct trace_event {
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+/* relaxed atomics so a dump can read a slot while its thread rewrites it,
+ * a slot that may have been rewritten is discarded after copying */
+struct trace_slot {
+    std::atomic<const char *> name;
+    std::atomic<uint64_t> start_ns;
+    std::atomic<uint64_t> end_ns;
+};
+
+struct trace_thread_buffer {
+    uint32_t tid{};
+    std::string name;
+    /* only the owning thread writes events and advances write_idx */
+    std::atomic<uint64_t> write_idx{};
+    std::atomic<uint64_t> read_start{};
+    /* set once the owning thread exited, the events stay until dumped */
+    bool retired{};
+    trace_slot events[TRACE_RING_SIZE];
+};
+
+struct trace_registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<trace_thread_buffer>> buffers;
+    /* buffers of exited threads that were dumped or reset, reused by new threads */
+    std::vector<std::unique_ptr<trace_thread_buffer>> free_buffers;
+    uint32_t next_tid{1};
+    std::atomic_bool enabled{true};
+};
+
+static trace_registry *get_registry()
+{
+    /* leaked so threads that exit during shutdown never touch a dead registry */
+    static trace_registry *registry = new trace_registry();
+    return registry;
+}
+
+struct trace_thread_owner {
+    ~trace_thread_owner();
+};
+
+static thread_local trace_thread_buffer *thread_buffer = nullptr;
+static thread_local bool thread_exited = false;
+static thread_local trace_thread_owner thread_owner;
+
+trace_thread_owner::~trace_thread_owner()
+{
+    thread_exited = true;
+    if (!thread_buffer)
+        return;
+
+    std::lock_guard<std::mutex> lock(get_registry()->mutex);
+    thread_buffer->retired = true;
+    thread_buffer = nullptr;
+}
+
+/* move the retired buffers to the free list, their events are gone after this */
+static void recycle_retired_buffers(trace_registry *registry)
+{
+    auto &buffers = registry->buffers;
+    for (auto it = buffers.begin(); it != buffers.end();) {
+        if ((*it)->retired) {
+            registry->free_buffers.push_back(std::move(*it));
+            it = buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static trace_thread_buffer *get_thread_buffer()
+{
+    if (thread_buffer || thread_exited)
+        return thread_buffer;
+
+    auto registry = get_registry();
+    std::unique_ptr<trace_thread_buffer> buffer;
+
+    std::lock_guard<std::mutex> lock(registry->mutex);
+    if (!registry->free_buffers.empty()) {
+        buffer = std::move(registry->free_buffers.back());
+        registry->free_buffers.pop_back();
+        buffer->name.clear();
+        buffer->write_idx = 0;
+        buffer->read_start = 0;
+        buffer->retired = false;
+    } else {
+        buffer = std::make_unique<trace_thread_buffer>();
+    }
+
+    buffer->tid = registry->next_tid++;
+    thread_buffer = buffer.get();
+    registry->buffers.push_back(std::move(buffer));
+
+    /* touch the owner so its destructor runs when this thread exits */
+    (void)&thread_owner;
+
+    return thread_buffer;
+}
+
+void trace_set_enabled(bool enabled)
+{
+    get_registry()->enabled = enabled;
+}
+
+bool trace_enabled()
+{
+    return get_registry()->enabled.load(std::memory_order_relaxed);
+}
+
+void trace_set_thread_name(const char *name)
+{
+    auto buffer = get_thread_buffer();
+    if (!buffer)
+        return;
+
+    std::lock_guard<std::mutex> lock(get_registry()->mutex);
+    buffer->name = name;
+}
+
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns)
+{
+    auto buffer = get_thread_buffer();
+    if (!buffer)
+        return;
+
+    uint64_t idx = buffer->write_idx.load(std::memory_order_relaxed);
+
+    /* a dump that sees any of the stores below also sees write_idx >= idx */
+    std::atomic_thread_fence(std::memory_order_release);
+
+    trace_slot &slot = buffer->events[idx & TRACE_RING_MASK];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+
+    buffer->write_idx.store(idx + 1, std::memory_order_release);
+}
+
+void trace_reset()
+{
+    auto registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry->mutex);
+
+    for (auto &buffer : registry->buffers)
+        buffer->read_start = buffer->write_idx.load(std::memory_order_acquire);
+
+    recycle_retired_buffers(registry);
+}
+
+bool trace_dump_json(const char *path)
+{
+    auto registry = get_registry();
+
+    FILE *f = fopen(path, "w");
+    if (!f) {
+        blog(LOG_WARNING, "trace_dump_json: failed to open '%s'", path);
+        return false;
+    }
+
+    struct thread_events { uint32_t tid; std::string name; std::vector<trace_event> events; };
+    std::vector<thread_events> threads;
+    uint64_t time_base = UINT64_MAX;
+
+    {
+        std::lock_guard<std::mutex> lock(registry->mutex);
+
+        for (auto &buffer : registry->buffers) {
+            uint64_t end = buffer->write_idx.load(std::memory_order_acquire);
+            uint64_t begin = buffer->read_start.load(std::memory_order_relaxed);
+            if (end - begin > TRACE_RING_SIZE)
+                begin = end - TRACE_RING_SIZE;
+
+            thread_events t{buffer->tid, buffer->name, {}};
+            t.events.reserve(end - begin);
+            for (uint64_t i = begin; i < end; i++) {
+                const trace_slot &slot = buffer->events[i & TRACE_RING_MASK];
+                t.events.push_back({slot.name.load(std::memory_order_relaxed),
+                                    slot.start_ns.load(std::memory_order_relaxed),
+                                    slot.end_ns.load(std::memory_order_relaxed)});
+            }
+
+            /* the writer may have wrapped onto the oldest slots while they
+             * were copied, including the one it is writing right now */
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t written = buffer->write_idx.load(std::memory_order_relaxed);
+            if (written + 1 > begin + TRACE_RING_SIZE) {
+                uint64_t overwritten = written + 1 - TRACE_RING_SIZE - begin;
+                if (overwritten > t.events.size())
+                    overwritten = t.events.size();
+                t.events.erase(t.events.begin(), t.events.begin() + overwritten);
+            }
+
+            for (auto &ev : t.events) {
+                if (ev.name && ev.start_ns < time_base)
+                    time_base = ev.start_ns;
+            }
+
+            threads.push_back(std::move(t));
+        }
+
+        /* retired threads are in the snapshot, their buffers can be reused */
+        recycle_retired_buffers(registry);
+    }
+
+    if (time_base == UINT64_MAX)
+        time_base = 0;
+
+    fprintf(f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+
+    bool first = true;
+    for (auto &t : threads) {
+        fprintf(f, "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+                first ? "" : ",\n", t.tid, t.name.empty() ? "thread" : t.name.c_str());
+        first = false;
+
+        for (auto &ev : t.events) {
+            if (!ev.name || ev.end_ns < ev.start_ns)
+                continue;
+
+            fprintf(f, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                    ev.name, t.tid,
+                    (double)(ev.start_ns - time_base) / 1000.0,
+                    (double)(ev.end_ns - ev.start_ns) / 1000.0);
+        }
+    }
+
+    fprintf(f, "\n]}\n");
+    fclose(f);
+
+    return true;
+}
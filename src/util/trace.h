@@ -0,0 +1,51 @@
+#pragma once
+
+#include <stdint.h>
+
+/*
+ * Scoped trace spans.  Each thread records into its own fixed size ring, so
+ * recording is a couple of clock reads and stores with no locking; the rings
+ * can be dumped at any time as Chrome trace event JSON (chrome://tracing,
+ * ui.perfetto.dev).  Without LITEOBS_ENABLE_TRACE the macros compile to
+ * nothing.  Span names must be string literals (or otherwise outlive the
+ * dump).
+ */
+
+void trace_set_enabled(bool enabled);
+bool trace_enabled();
+
+void trace_set_thread_name(const char *name);
+void trace_record(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+bool trace_dump_json(const char *path);
+void trace_reset();
+
+#ifdef LITEOBS_ENABLE_TRACE
+
+#include "threading.h"
+
+class trace_scope
+{
+public:
+    trace_scope(const char *name) : name(name), start(trace_enabled() ? os_gettime_ns() : 0) {}
+    ~trace_scope() {
+        if (start)
+            trace_record(name, start, os_gettime_ns());
+    }
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) trace_scope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#define TRACE_THREAD_NAME(name) trace_set_thread_name(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+
+#endif